@@ -0,0 +1,399 @@
+#include "../src/console.hpp"
+#include "../src/metrics.hpp"
+#include "../src/null_renderer.hpp"
+#include "../src/numerical.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Headless benchmark suite for the library: timestamped_message
+// throughput from 1 to N threads, render-loop latency, Message
+// construction, disabled log calls, command dispatch, ThreadedProcess
+// start-up and shutdown, and get_stats on large vectors. Every case is
+// repeated and summarised (min, median, p99, mean, std dev) through
+// Numerical; the results are written as one JSON document so runs can be
+// diffed release to release, and a readable table goes to stderr.
+//
+//     console_bench [max threads] [results file, console_bench.json]
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using namespace ConsoleWriter;
+
+    struct Result {
+	std::string _name;
+	std::string _unit;
+	size_t _threads;
+	Numerical::Statistics<double> _stats;
+	double _p99;
+	size_t _samples;
+    };
+
+    std::vector<Result> _results;
+
+    // keeps the optimiser from dropping a result
+    volatile double _sink;
+
+    double
+    ns_since
+    (Clock::time_point const start) {
+	return std::chrono::duration<double, std::nano>
+	    (Clock::now() - start).count();
+    };
+
+    void
+    report
+    (std::string name, std::string unit, size_t const threads,
+     std::vector<double> const& samples) {
+	Numerical::StreamingStatistics streaming;
+	for (const double sample : samples) {
+	    streaming.add(sample);
+	};
+	Result result { std::move(name), std::move(unit), threads,
+			Numerical::get_stats(samples),
+			streaming.quantile(0.99), samples.size() };
+	std::fprintf(stderr, "%-28s %3zu %12.1f %12.1f %12.1f  %s\n",
+		     result._name.c_str(), threads, result._stats._min,
+		     result._stats._median, result._p99,
+		     result._unit.c_str());
+	_results.push_back(std::move(result));
+    };
+
+    // waits for the console to have drawn lines lines in all
+    void
+    wait_for_lines
+    (NullRenderer const& renderer, size_t const lines) {
+	while (renderer.lines() < lines) {
+	    std::this_thread::yield();
+	};
+    };
+
+    void
+    bench_throughput
+    (NullRenderer const& renderer, size_t const max_threads) {
+	constexpr size_t MESSAGES { 200000 };
+	constexpr size_t REPEATS { 5 };
+	for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+	    std::vector<double> samples;
+	    for (size_t r = 0; r < REPEATS; ++r) {
+		const size_t per_thread = MESSAGES / threads;
+		const size_t target = renderer.lines() +
+		    per_thread * threads;
+		std::vector<std::thread> producers;
+		const auto start = Clock::now();
+		for (size_t t = 0; t < threads; ++t) {
+		    producers.emplace_back([t, per_thread] () {
+			// distinct text, so the repeat filter keeps all
+			const std::string prefix = "bench " +
+			    std::to_string(t) + " ";
+			for (size_t i = 0; i < per_thread; ++i) {
+			    timestamped_message(prefix + std::to_string(i));
+			};
+		    });
+		};
+		for (auto& producer : producers) {
+		    producer.join();
+		};
+		wait_for_lines(renderer, target);
+		samples.push_back(static_cast<double>
+				  (per_thread * threads) /
+				  (ns_since(start) / 1e9));
+	    };
+	    report("timestamped_message", "msgs/s", threads, samples);
+	};
+    };
+
+    void
+    bench_render_latency
+    (NullRenderer const& renderer) {
+	constexpr size_t SAMPLES { 2000 };
+	std::vector<double> samples;
+	samples.reserve(SAMPLES);
+	for (size_t i = 0; i < SAMPLES; ++i) {
+	    const size_t target = renderer.lines() + 1;
+	    const auto start = Clock::now();
+	    timestamped_message("latency " + std::to_string(i));
+	    wait_for_lines(renderer, target);
+	    samples.push_back(ns_since(start) / 1000.0);
+	};
+	report("render_latency", "us", 1, samples);
+    };
+
+    void
+    bench_message_construction
+    () {
+	constexpr size_t BATCHES { 500 };
+	constexpr size_t BATCH { 1000 };
+	const std::string text {
+	    "the quick brown fox jumps over the lazy dog" };
+	std::vector<double> samples;
+	for (size_t b = 0; b < BATCHES; ++b) {
+	    const auto start = Clock::now();
+	    for (size_t i = 0; i < BATCH; ++i) {
+		Message msg(text.size());
+		msg.stamp();
+		msg.add_chunk(text, Message::NORMAL);
+		_sink = static_cast<double>(msg._enqueued
+					    .time_since_epoch().count());
+	    };
+	    samples.push_back(ns_since(start) / BATCH);
+	};
+	report("message_construction", "ns", 1, samples);
+    };
+
+    // a debug call the runtime level turns away, with every channel at
+    // the default and with one channel let through to trace
+    void
+    bench_disabled_log
+    () {
+	constexpr size_t BATCHES { 500 };
+	constexpr size_t BATCH { 100000 };
+	std::vector<double> samples;
+	for (const bool other_channel : { false, true }) {
+	    if (other_channel) {
+		set_log_level(channel("console_bench"), LogLevel::TRACE);
+	    };
+	    samples.clear();
+	    for (size_t b = 0; b < BATCHES; ++b) {
+		const auto start = Clock::now();
+		for (size_t i = 0; i < BATCH; ++i) {
+		    CONSOLE_LOG(LogLevel::DEBUG, "disabled ", i);
+		};
+		samples.push_back(ns_since(start) / BATCH);
+	    };
+	    report(other_channel ? "disabled_log_other_channel" :
+		   "disabled_log", "ns", 1, samples);
+	};
+	clear_log_level(channel("console_bench"));
+    };
+
+    // split, resolve, bind and call, as handle_command does for an inline
+    // command
+    void
+    bench_command_dispatch
+    () {
+	constexpr size_t BATCHES { 500 };
+	constexpr size_t BATCH { 1000 };
+	CommandRegistry registry;
+	for (size_t i = 0; i < 64; ++i) {
+	    registry.add("command" + std::to_string(i),
+			 std::make_shared<Command>
+			 ("filler", [] (std::string const& arg) {
+			     return arg;
+			 }, true));
+	};
+	registry.add("resize", std::make_shared<Command>
+		     ("typed",
+		      ArgumentSchema().required("rows", ArgumentType::INTEGER)
+		      .option("every", ArgumentType::DURATION),
+		      [] (Arguments const& args) {
+			  return std::to_string(args.integer(0).value_or(0));
+		      }, true));
+	const std::string line { "resi 42 --every=10ms" };
+	std::vector<double> samples;
+	for (size_t b = 0; b < BATCHES; ++b) {
+	    const auto start = Clock::now();
+	    for (size_t i = 0; i < BATCH; ++i) {
+		const auto pos = line.find(' ');
+		const auto lookup = registry.snapshot()
+		    .resolve(line.substr(0, pos));
+		Arguments arguments(line.substr(pos + 1));
+		if (lookup._command->_schema->bind(arguments).empty()) {
+		    _sink = static_cast<double>
+			(lookup._command->_typed_callback(arguments).size());
+		};
+	    };
+	    samples.push_back(ns_since(start) / BATCH);
+	};
+	report("command_dispatch", "ns", 1, samples);
+
+	// a command handed to the worker pool and its completion seen
+	CommandExecutor executor(4);
+	samples.clear();
+	for (size_t i = 0; i < 2000; ++i) {
+	    std::promise<void> done;
+	    const auto start = Clock::now();
+	    executor.submit("bench", [] () { return std::string(); },
+			    [&] (CommandExecutor::JobInfo const&,
+				 std::string const&) {
+				done.set_value();
+			    });
+	    done.get_future().wait();
+	    samples.push_back(ns_since(start) / 1000.0);
+	};
+	report("command_executor_round_trip", "us", 1, samples);
+    };
+
+    class IdleProcess final : public ThreadedProcess {
+    public:
+	explicit IdleProcess(ExecutionMode const mode) : _mode(mode) {}
+
+	~IdleProcess() {
+	    shutdown();
+	    join();
+	};
+
+	std::string process_name() const noexcept override { return "Idle"; }
+
+	void
+	start
+	() override {
+	    _running = true;
+	    if (_mode == ExecutionMode::COOPERATIVE) {
+		start_cooperative();
+		resume();
+		return;
+	    };
+	    _thread = std::make_shared<std::thread>([&] () {
+		_started.store(true);
+		std::unique_lock<std::mutex> lock(_lock);
+		_cv.wait(lock, [&] () { return !_running; });
+		set_deletable();
+	    });
+	};
+
+	bool started() const noexcept { return _started.load(); }
+    private:
+	void
+	on_shutdown
+	() noexcept override {
+	    std::scoped_lock<std::mutex> lock(_lock);
+	    _cv.notify_all();
+	};
+
+	bool
+	run_once
+	() override {
+	    _started.store(true);
+	    if (!_running) {
+		set_deletable();
+	    };
+	    return false;
+	};
+
+	ExecutionMode const _mode;
+	std::atomic<bool> _started { false };
+	std::mutex _lock;
+	std::condition_variable _cv;
+    };
+
+    // launch() until the process is running, and shutdown() until it has
+    // finished
+    void
+    bench_process_lifecycle
+    (char const* mode_name, ExecutionMode const mode) {
+	constexpr size_t SAMPLES { 500 };
+	std::vector<double> start_samples;
+	std::vector<double> stop_samples;
+	for (size_t i = 0; i < SAMPLES; ++i) {
+	    IdleProcess process(mode);
+	    auto start = Clock::now();
+	    process.launch();
+	    while (!process.started()) {
+		std::this_thread::yield();
+	    };
+	    start_samples.push_back(ns_since(start) / 1000.0);
+	    start = Clock::now();
+	    process.shutdown();
+	    process.finished().wait();
+	    stop_samples.push_back(ns_since(start) / 1000.0);
+	};
+	report(std::string("process_start_") + mode_name, "us", 1,
+	       start_samples);
+	report(std::string("process_stop_") + mode_name, "us", 1,
+	       stop_samples);
+    };
+
+    void
+    bench_get_stats
+    (size_t const count, size_t const repeats) {
+	std::mt19937_64 rng(count);
+	std::normal_distribution<double> dist(1000.0, 50.0);
+	std::vector<double> values(count);
+	for (auto& value : values) {
+	    value = dist(rng);
+	};
+	std::vector<double> samples;
+	for (size_t r = 0; r < repeats; ++r) {
+	    const auto start = Clock::now();
+	    _sink = Numerical::get_stats(values)._std_dev;
+	    samples.push_back(ns_since(start) / 1e6);
+	};
+	report("get_stats_" + std::to_string(count), "ms", 1, samples);
+    };
+
+    std::string
+    to_json
+    (size_t const max_threads) {
+	std::stringstream ss;
+	ss.precision(6);
+	ss << "{\"benchmark\":\"console_bench\",\"max_threads\":"
+	   << max_threads << ",\"results\":[";
+	for (size_t i = 0; i < _results.size(); ++i) {
+	    auto const& result = _results[i];
+	    ss << (i == 0 ? "" : ",") << "\n{\"name\":";
+	    write_json_string(ss, result._name);
+	    ss << ",\"unit\":";
+	    write_json_string(ss, result._unit);
+	    ss << ",\"threads\":" << result._threads
+	       << ",\"samples\":" << result._samples
+	       << ",\"min\":" << result._stats._min
+	       << ",\"median\":" << result._stats._median
+	       << ",\"p99\":" << result._p99
+	       << ",\"mean\":" << result._stats._mean
+	       << ",\"std_dev\":" << result._stats._std_dev
+	       << ",\"max\":" << result._stats._max << "}";
+	};
+	ss << "\n]}\n";
+	return ss.str();
+    };
+};
+
+int main(int argc, char *argv[])
+{
+    const size_t max_threads = argc > 1 ?
+	static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) :
+	std::max<size_t>(4, std::thread::hardware_concurrency());
+    const std::string path = argc > 2 ? argv[2] : "console_bench.json";
+
+    std::fprintf(stderr, "%-28s %3s %12s %12s %12s\n", "benchmark",
+		 "thr", "min", "median", "p99");
+    {
+	auto renderer = std::make_unique<NullRenderer>();
+	NullRenderer const& counts = *renderer;
+	auto console = ConsoleInterface::create(std::move(renderer));
+	// render as soon as messages arrive, so latency is the pipeline's
+	console->set_max_frame_rate(0);
+	bench_throughput(counts, std::max<size_t>(1, max_threads));
+	bench_render_latency(counts);
+	console->shutdown();
+	console->finished().wait();
+	shutdown();
+    }
+    bench_message_construction();
+    bench_disabled_log();
+    bench_command_dispatch();
+    bench_process_lifecycle("thread", ExecutionMode::DEDICATED_THREAD);
+    bench_process_lifecycle("cooperative", ExecutionMode::COOPERATIVE);
+    bench_get_stats(1000000, 20);
+    bench_get_stats(16000000, 5);
+
+    std::ofstream out(path);
+    out << to_json(max_threads);
+    if (!out) {
+	std::fprintf(stderr, "could not write %s\n", path.c_str());
+	return 1;
+    };
+    std::fprintf(stderr, "results written to %s\n", path.c_str());
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "../src/message.hpp"
+#include "../src/numerical.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+// Heap allocations and construction cost per console message, for the old
+// vector-of-strings layout and the pooled single-buffer Message.
+
+namespace {
+    std::atomic<size_t> _allocations { 0 };
+};
+
+void* operator new(size_t size) {
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+	return p;
+    };
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // the representation Message had before it moved to pooled storage
+    struct LegacyMessage {
+	void add_chunk(std::string msg, int const colour) {
+	    _strs.emplace_back(msg);
+	    _colour_pairs.push_back(colour);
+	};
+	std::vector<int> _colour_pairs;
+	std::vector<std::string> _strs;
+    };
+
+    const std::string _timestamp { "[2024-01-01 12:00:00]" };
+    const std::string _text
+    { "worker 17 finished processing batch 4096 of the nightly import" };
+
+    template <typename Build>
+    void
+    measure
+    (char const* name, size_t const count, Build&& build) {
+	// warm up so the pool reaches its steady state
+	for (size_t i = 0; i < count; ++i) {
+	    build();
+	};
+	std::vector<double> timings;
+	timings.reserve(count);
+	const size_t before = _allocations.load();
+	for (size_t i = 0; i < count; ++i) {
+	    const auto start = Clock::now();
+	    build();
+	    timings.push_back(std::chrono::duration<double, std::nano>
+			      (Clock::now() - start).count());
+	};
+	const size_t allocations = _allocations.load() - before;
+	const auto stats = Numerical::get_stats(timings);
+	std::printf("%-8s %14.2f %12.1f %12.1f\n", name,
+		    static_cast<double>(allocations) /
+		    static_cast<double>(count),
+		    stats._median, stats._mean);
+    };
+};
+
+int main(int argc, char *argv[])
+{
+    const size_t count = argc > 1 ?
+	static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 100000;
+    std::printf("%-8s %14s %12s %12s\n",
+		"layout", "allocs/msg", "p50 ns", "mean ns");
+    measure("legacy", count, [] () {
+	LegacyMessage msg;
+	msg.add_chunk(_timestamp, 3);
+	msg.add_chunk("[ERROR]", 2);
+	msg.add_chunk(_text, 0);
+    });
+    measure("pooled", count, [] () {
+	ConsoleWriter::Message msg(7 + _text.size());
+	msg.stamp();
+	msg.add_chunk("[ERROR]", ConsoleWriter::Message::ERROR);
+	msg.add_chunk(_text, ConsoleWriter::Message::NORMAL);
+    });
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "../src/mpsc_queue.hpp"
+#include "../src/numerical.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Enqueue latency and throughput of the console message queue against the
+// mutex + std::queue pair it replaced, at 1 to 64 producer threads.
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // every n-th push is timed so the clock reads don't dominate the run
+    constexpr size_t SAMPLE_EVERY { 16 };
+    constexpr size_t QUEUE_CAPACITY { 8192 };
+
+    class LockedQueue {
+    public:
+	void push(std::string&& value) {
+	    std::scoped_lock<std::mutex> lock(_lock);
+	    _queue.emplace(std::move(value));
+	};
+
+	template <typename Consumer>
+	size_t pop_batch(Consumer&& consumer) {
+	    size_t count = 0;
+	    while (true) {
+		std::scoped_lock<std::mutex> lock(_lock);
+		if (_queue.empty()) {
+		    return count;
+		};
+		consumer(std::move(_queue.front()));
+		_queue.pop();
+		++count;
+	    };
+	};
+    private:
+	std::mutex _lock;
+	std::queue<std::string> _queue;
+    };
+
+    struct Result {
+	double _seconds;
+	std::vector<double> _latencies_ns;
+    };
+
+    template <typename Queue>
+    Result
+    run
+    (Queue& queue, size_t const producers, size_t const per_producer) {
+	std::atomic<bool> go { false };
+	std::atomic<size_t> consumed { 0 };
+	const size_t total = producers * per_producer;
+	std::vector<std::vector<double>> samples(producers);
+
+	std::thread consumer([&] () {
+	    size_t bytes = 0;
+	    while (consumed.load(std::memory_order_relaxed) < total) {
+		const size_t n = queue.pop_batch([&] (std::string&& s) {
+		    bytes += s.size();
+		});
+		if (n == 0) {
+		    std::this_thread::yield();
+		};
+		consumed.fetch_add(n, std::memory_order_relaxed);
+	    };
+	    if (bytes == 0) {
+		std::abort();
+	    };
+	});
+
+	std::vector<std::thread> threads;
+	for (size_t p = 0; p < producers; ++p) {
+	    threads.emplace_back([&, p] () {
+		auto& local = samples[p];
+		local.reserve(per_producer / SAMPLE_EVERY + 1);
+		while (!go.load(std::memory_order_acquire)) {
+		    std::this_thread::yield();
+		};
+		for (size_t i = 0; i < per_producer; ++i) {
+		    std::string payload("[2024-01-01 00:00:00] worker message");
+		    if (i % SAMPLE_EVERY == 0) {
+			const auto start = Clock::now();
+			queue.push(std::move(payload));
+			const auto end = Clock::now();
+			local.push_back(std::chrono::duration<double, std::nano>
+					(end - start).count());
+		    } else {
+			queue.push(std::move(payload));
+		    };
+		};
+	    });
+	};
+
+	const auto start = Clock::now();
+	go.store(true, std::memory_order_release);
+	for (auto& t : threads) {
+	    t.join();
+	};
+	consumer.join();
+	const auto end = Clock::now();
+
+	Result result;
+	result._seconds = std::chrono::duration<double>(end - start).count();
+	for (auto const& s : samples) {
+	    result._latencies_ns.insert(result._latencies_ns.end(),
+					s.begin(), s.end());
+	};
+	return result;
+    };
+
+    void
+    report
+    (char const* name, size_t const producers, size_t const total,
+     Result& result) {
+	const auto stats = Numerical::get_stats(result._latencies_ns);
+	auto& lat = result._latencies_ns;
+	const size_t p99_index = lat.size() * 99 / 100;
+	std::nth_element(lat.begin(), lat.begin() + p99_index, lat.end());
+	std::printf("%-8s %8zu %14.0f %12.1f %12.1f %12.1f\n",
+		    name, producers,
+		    static_cast<double>(total) / result._seconds,
+		    stats._median, stats._mean, lat[p99_index]);
+    };
+};
+
+int main(int argc, char *argv[])
+{
+    const size_t total = argc > 1 ?
+	static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 1 << 20;
+    const size_t thread_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    std::printf("%-8s %8s %14s %12s %12s %12s\n",
+		"queue", "threads", "msgs/s", "p50 ns", "mean ns", "p99 ns");
+    for (const size_t producers : thread_counts) {
+	const size_t per_producer = std::max<size_t>(total / producers, 1);
+	{
+	    ConsoleWriter::MpscQueue<std::string> queue(QUEUE_CAPACITY);
+	    auto result = run(queue, producers, per_producer);
+	    report("mpsc", producers, producers * per_producer, result);
+	}
+	{
+	    LockedQueue queue;
+	    auto result = run(queue, producers, per_producer);
+	    report("mutex", producers, producers * per_producer, result);
+	}
+    };
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "../src/numerical.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+// get_stats kernels for float, double and int64 from 1k to 100M elements:
+// the fused moments pass with each instruction set and threaded, against
+// the accumulate + pow loop it replaced, and nth_element against a full
+// sort for the median.
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+    using Numerical::Kernels::InstructionSet;
+
+    // the legacy full sort is skipped past this size; it takes seconds
+    constexpr size_t LEGACY_LIMIT { 10000000 };
+
+    // smallest time of a few runs sized to ~20M elements of work
+    template <typename Run>
+    double
+    best_ns_per_element
+    (size_t const count, Run&& run) {
+	const size_t repeats = std::max<size_t>(3, 20000000 / count);
+	double best = 1e300;
+	for (size_t r = 0; r < repeats; ++r) {
+	    const auto start = Clock::now();
+	    run();
+	    const auto end = Clock::now();
+	    best = std::min(best, std::chrono::duration<double, std::nano>
+			    (end - start).count());
+	};
+	return best / static_cast<double>(count);
+    };
+
+    template <typename T>
+    std::vector<T>
+    make_values
+    (size_t const count) {
+	std::mt19937_64 rng(count);
+	std::normal_distribution<double> dist(1000.0, 50.0);
+	std::vector<T> values(count);
+	for (auto& value : values) {
+	    value = static_cast<T>(dist(rng));
+	};
+	return values;
+    };
+
+    // keeps the optimiser from dropping a result
+    volatile double _sink;
+
+    template <typename T>
+    void
+    run
+    (char const* name, size_t const count) {
+	const auto values = make_values<T>(count);
+	const unsigned int cores =
+	    std::max(1u, std::thread::hardware_concurrency());
+
+	auto moments = [&] (InstructionSet const set,
+			    unsigned int const threads) {
+	    Numerical::Kernels::set_instruction_set(set);
+	    const double ns = best_ns_per_element(count, [&] () {
+		_sink = Numerical::Kernels::moments(values.data(), count,
+						    threads)._m2;
+	    });
+	    Numerical::Kernels::set_instruction_set(InstructionSet::AVX2);
+	    return ns;
+	};
+	const double scalar = moments(InstructionSet::SCALAR, 1);
+	const double sse2 = moments(InstructionSet::SSE2, 1);
+	const double avx2 = moments(InstructionSet::AVX2, 1);
+	const double threaded = moments(InstructionSet::AVX2, cores);
+
+	const double legacy = count > LEGACY_LIMIT ? NAN :
+	    best_ns_per_element(count, [&] () {
+		T total = std::accumulate(values.begin(), values.end(),
+					  static_cast<T>(0));
+		const T mean = total / static_cast<T>(count);
+		T var = 0;
+		for (const auto& val : values) {
+		    var += pow((val - mean), 2);
+		};
+		_sink = static_cast<double>(var);
+	    });
+	const double sorted = count > LEGACY_LIMIT ? NAN :
+	    best_ns_per_element(count, [&] () {
+		std::vector<T> copy = values;
+		std::sort(copy.begin(), copy.end());
+		_sink = static_cast<double>(copy[count / 2]);
+	    });
+	const double selected = best_ns_per_element(count, [&] () {
+	    _sink = static_cast<double>(Numerical::average_median(values));
+	});
+
+	std::printf("%-7s %10zu %9.3f %9.3f %9.3f %9.3f %9.3f %9.2f %9.2f\n",
+		    name, count, legacy, scalar, sse2, avx2, threaded,
+		    sorted, selected);
+    };
+};
+
+int main(int argc, char *argv[])
+{
+    const size_t max_count = argc > 1 ?
+	static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 100000000;
+
+    std::printf("instruction set: %s, %u threads, ns per element\n",
+		Numerical::Kernels::to_string(
+		    Numerical::Kernels::supported_instruction_set()),
+		std::max(1u, std::thread::hardware_concurrency()));
+    std::printf("%-7s %10s %9s %9s %9s %9s %9s %9s %9s\n",
+		"type", "n", "legacy", "scalar", "sse2", "avx2", "threads",
+		"sort", "nth");
+    for (size_t count = 1000; count <= max_count; count *= 10) {
+	run<float>("float", count);
+	run<double>("double", count);
+	run<int64_t>("int64", count);
+    };
+    return 0;
+}
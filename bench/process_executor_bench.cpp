@@ -0,0 +1,191 @@
+#include "../src/threaded_process.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 1,000 lightweight processes passing tokens round a ring, each process on
+// a thread of its own against all of them as cooperative tasks on the
+// shared work-stealing executor: start-up, hop throughput and shutdown.
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t TOKENS { 64 };
+
+    struct Ring {
+	std::atomic<int64_t> _hops_left { 0 };
+	std::mutex _done_lock;
+	std::condition_variable _done_cv;
+	bool _done { false };
+    };
+
+    class RingProcess final : public ThreadedProcess {
+    public:
+	RingProcess(ExecutionMode const mode, Ring& ring)
+	    : _mode(mode)
+	    , _ring(ring) {
+	};
+
+	~RingProcess() {
+	    shutdown();
+	    join();
+	};
+
+	std::string process_name() const noexcept override { return "Ring"; }
+
+	void
+	start
+	() override {
+	    _running = true;
+	    if (_mode == ExecutionMode::COOPERATIVE) {
+		start_cooperative();
+		return;
+	    };
+	    _thread = std::make_shared<std::thread>([&] () { run_loop(); });
+	};
+
+	void set_next(RingProcess* next) noexcept { _next = next; }
+
+	void
+	deliver
+	() {
+	    _mailbox.fetch_add(1);
+	    if (_task) {
+		resume();
+		return;
+	    };
+	    std::scoped_lock<std::mutex> lock(_lock);
+	    _cv.notify_one();
+	};
+    private:
+	void
+	on_shutdown
+	() noexcept override {
+	    std::scoped_lock<std::mutex> lock(_lock);
+	    _cv.notify_all();
+	};
+
+	bool
+	run_once
+	() override {
+	    if (!_running) {
+		set_deletable();
+		return false;
+	    };
+	    forward();
+	    return false;
+	};
+
+	void
+	run_loop
+	() {
+	    while (_running) {
+		{
+		    std::unique_lock<std::mutex> lock(_lock);
+		    _cv.wait(lock, [&] () {
+			return _mailbox.load() > 0 || !_running;
+		    });
+		}
+		forward();
+	    };
+	    set_deletable();
+	};
+
+	void
+	forward
+	() {
+	    for (uint64_t n = _mailbox.exchange(0); n > 0; --n) {
+		const int64_t left = _ring._hops_left.fetch_sub(1);
+		if (left > 1) {
+		    _next->deliver();
+		} else if (left == 1) {
+		    std::scoped_lock<std::mutex> lock(_ring._done_lock);
+		    _ring._done = true;
+		    _ring._done_cv.notify_all();
+		};
+	    };
+	};
+
+	ExecutionMode const _mode;
+	Ring& _ring;
+	RingProcess* _next { nullptr };
+	std::atomic<uint64_t> _mailbox { 0 };
+	std::mutex _lock;
+	std::condition_variable _cv;
+    };
+
+    double
+    ms_since
+    (Clock::time_point const start) {
+	return std::chrono::duration<double, std::milli>
+	    (Clock::now() - start).count();
+    };
+
+    void
+    run
+    (char const* name, ExecutionMode const mode, size_t const processes,
+     int64_t const hops) {
+	Ring ring;
+	ring._hops_left = hops;
+	std::vector<std::unique_ptr<RingProcess>> ring_processes;
+	ring_processes.reserve(processes);
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < processes; ++i) {
+	    ring_processes.push_back(std::make_unique<RingProcess>(mode, ring));
+	};
+	for (size_t i = 0; i < processes; ++i) {
+	    ring_processes[i]->set_next(
+		ring_processes[(i + 1) % processes].get());
+	    ring_processes[i]->launch();
+	};
+	const double start_ms = ms_since(start);
+
+	start = Clock::now();
+	for (size_t t = 0; t < TOKENS; ++t) {
+	    ring_processes[t * processes / TOKENS]->deliver();
+	};
+	{
+	    std::unique_lock<std::mutex> lock(ring._done_lock);
+	    ring._done_cv.wait(lock, [&] () { return ring._done; });
+	}
+	const double seconds = ms_since(start) / 1000.0;
+
+	start = Clock::now();
+	ring_processes.clear();
+	const double stop_ms = ms_since(start);
+
+	std::printf("%-12s %6zu %10.1f %14.0f %10.1f\n",
+		    name, processes, start_ms,
+		    static_cast<double>(hops) / seconds, stop_ms);
+    };
+};
+
+int main(int argc, char *argv[])
+{
+    const size_t processes = argc > 1 ?
+	static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 1000;
+    const int64_t hops = argc > 2 ? std::strtoll(argv[2], nullptr, 10) :
+	1000000;
+
+    auto& executor = ProcessExecutor::shared();
+    std::printf("executor: %zu worker threads, %lld hops, %zu tokens\n",
+		executor.threads(), static_cast<long long>(hops), TOKENS);
+    std::printf("%-12s %6s %10s %14s %10s\n",
+		"mode", "procs", "start ms", "hops/s", "stop ms");
+    run("cooperative", ExecutionMode::COOPERATIVE, processes, hops);
+    run("thread", ExecutionMode::DEDICATED_THREAD, processes, hops);
+
+    const auto stats = executor.stats();
+    std::printf("executor runs %llu, steals %llu, parks %llu\n",
+		static_cast<unsigned long long>(stats._runs),
+		static_cast<unsigned long long>(stats._steals),
+		static_cast<unsigned long long>(stats._parks));
+    return 0;
+}
@@ -1,7 +1,5 @@
 #include "../src/console.hpp"
-
-#include <mutex>
-#include <condition_variable>
+#include "../src/process_supervisor.hpp"
 
 int main(int argc, char *argv[])
 {
@@ -10,48 +8,67 @@ int main(int argc, char *argv[])
     auto add_cmd = std::make_shared<Command>
 	(
 	 "Add a series of space separated numbers",
-	 [cnsl = cnsl] (std::string const& args) {
+	 ArgumentSchema().variadic("number", ArgumentType::NUMBER, 1),
+	 [] (Arguments const& args) {
 	     double total = 0.0;
-	     size_t s_pos = 0;
-	     size_t pos = args.find(' ');
-	     do {
-		 try {
-		     total += static_cast<double>
-			 (std::stoi(args.substr(s_pos, pos)));
-		 } catch ( ... ) {
-		     total += 0.0;
-		 }
-		 s_pos = pos;
-		 pos = args.find(' ', pos);
-	     } while (pos != std::string::npos);
+	     for (size_t i = 0; i < args.size(); ++i) {
+		 total += *args.number(i);
+	     };
 	     return "The numerical total is : " + std::to_string(total);
 	 });
     
     cnsl->add_command("add", add_cmd);
 
-    std::mutex mtx;
-    std::condition_variable cv;
+    // progress is drawn in place above the separator rather than as a
+    // line per step; the console owns its commands, so this borrows the
+    // board rather than the console
+    StatusBoard& status = cnsl->status();
+    auto progress_cmd = std::make_shared<Command>
+	(
+	 "Count to a number on a progress bar",
+	 ArgumentSchema().optional("count", ArgumentType::INTEGER),
+	 [&status] (Arguments const& args) {
+	     const int64_t count = std::max<int64_t>(args.integer(0)
+						     .value_or(20000000), 1);
+	     auto bar = status.progress("progress");
+	     auto rate = status.rate("steps");
+	     bar->set(0, static_cast<uint64_t>(count));
+	     for (int64_t i = 0; i < count; ++i) {
+		 bar->advance();
+		 rate->mark();
+	     };
+	     return "Counted to " + std::to_string(count);
+	 });
+    cnsl->add_command("progress", progress_cmd);
 
+    // the console draws to the log, so the log outlives it
+    ProcessSupervisor supervisor;
+    supervisor.add(cnsl);
 
-    // Let the user terminate the programme from the terminal
-    // The terminal cleanup should be tied to the shutdown 
+    // example [log file]
+    if (argc > 1) {
+	LogSinkOptions options;
+	options._path = argv[1];
+	auto sink = std::make_shared<LogSink>(std::move(options));
+	cnsl->set_log_sink(sink);
+	supervisor.add(sink);
+	supervisor.add_dependency(*cnsl, *sink);
+    };
+    supervisor.start_all();
 
+    // Let the user terminate the programme from the terminal. The console
+    // owns its commands, so this one must not own the console
     auto shutdown_cmd = std::make_shared<Command>
 	(
 	 "Shut down the example programme",
-	 [cnsl = cnsl, cv_ptr = &cv](std::string const& args) {
-	     cnsl->shutdown();
-	     cv_ptr->notify_all();
+	 [&supervisor](std::string const& args) {
+	     supervisor.shutdown_all();
 	     return ""; 
 	 });
     cnsl->add_command("shutdown", shutdown_cmd);
     
-    std::unique_lock<std::mutex> lock(mtx);
-    cv.wait(lock, [&]() { return cnsl->is_deletable();});
-
-    std::cout <<"niciicescsdfs\n";
-    // make sure console is dead before we shutdown
-    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    supervisor.stopped().wait();
+    cnsl.reset();
     shutdown();
 		
     return 0;
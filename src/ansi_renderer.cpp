@@ -0,0 +1,69 @@
+#include "ansi_renderer.hpp"
+
+#include "timestamp.hpp"
+
+ConsoleWriter::AnsiRenderer::AnsiRenderer
+(std::ostream& out, bool const colour, int const columns)
+    : _out(out)
+    , _colour(colour)
+    , _columns(columns) {
+    _pending.reserve(4096);
+};
+
+std::string const&
+ConsoleWriter::AnsiRenderer::colour_code
+(int const colour) noexcept {
+    switch (colour) {
+    case Message::HIGHLIGHT:
+	return ESC::whi;
+    case Message::ERROR:
+	return ESC::red;
+    case Message::TIMESTAMP:
+	return ESC::cya;
+    case Message::INPUT:
+	return ESC::mag;
+    default:
+	return ESC::reset;
+    };
+};
+
+void
+ConsoleWriter::AnsiRenderer::append_line
+(size_t const, Message const& message) noexcept {
+    if (message.has_timestamp()) {
+	char stamp[Timestamp::MAX_WIDTH];
+	const size_t length = Timestamp::format(message._enqueued, true,
+						stamp);
+	if (_colour) {
+	    _pending += colour_code(Message::TIMESTAMP);
+	};
+	_pending.append(stamp, length);
+	_pending.push_back(' ');
+    };
+    for (size_t i = 0; i < message.chunk_count(); ++i) {
+	const Message::Chunk chunk = message.chunk(i);
+	if (_colour) {
+	    _pending += colour_code(chunk._colour);
+	};
+	_pending += chunk._text;
+	if (i + 1 != message.chunk_count()) {
+	    _pending.push_back(' ');
+	};
+    };
+    if (_colour) {
+	_pending += ESC::reset;
+    };
+    _pending.push_back('\n');
+};
+
+void
+ConsoleWriter::AnsiRenderer::present
+() noexcept {
+    if (_pending.empty()) {
+	return;
+    };
+    _out.write(_pending.data(), static_cast<std::streamsize>
+	       (_pending.size()));
+    _out.flush();
+    _pending.clear();
+};
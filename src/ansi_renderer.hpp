@@ -0,0 +1,54 @@
+#ifndef CLASS_ANSI_RENDERER
+#define CLASS_ANSI_RENDERER
+
+#include <iostream>
+#include <string>
+
+#include "renderer.hpp"
+
+namespace ConsoleWriter {
+    namespace ESC {
+	static const std::string red = "\u001b[38;5;196m";
+	static const std::string gre = "\u001b[38;5;82m";
+	static const std::string yel = "\u001b[38;5;226m";
+	static const std::string blu = "\u001b[38;5;21m";
+	static const std::string mag = "\u001b[38;5;165m";
+	static const std::string cya = "\u001b[38;5;51m";
+	static const std::string whi = "\u001b[38;5;225m";
+	static const std::string reset = "\033[0m";
+    };
+
+    // Writes each log line to a stream as it arrives, for pipes, CI logs
+    // and containers without a terminal. There is no screen to repaint,
+    // so paging, panes and the input line are ignored: the stream gets
+    // the focused pane's lines. A frame's lines are written with one
+    // stream write.
+    class AnsiRenderer final : public Renderer {
+    public:
+	explicit AnsiRenderer(std::ostream& out = std::cout,
+			      bool const colour = true,
+			      int const columns = 80);
+
+	// a stream has no screen to page through
+	int log_rows(size_t const) const noexcept override { return 1; }
+	int columns() const noexcept override { return _columns; }
+
+	void append_line(size_t const pane,
+			 Message const& message) noexcept override;
+	void draw_log_page(size_t const, RingBuffer<Message> const&,
+			   size_t const) noexcept override {}
+	void draw_separator(std::string const&) noexcept override {}
+	void draw_input_cell(size_t const, char const,
+			     bool const) noexcept override {}
+	void present() noexcept override;
+    private:
+	static std::string const& colour_code(int const colour) noexcept;
+
+	std::ostream& _out;
+	bool const _colour;
+	int const _columns;
+	std::string _pending;
+    };
+};
+
+#endif
@@ -0,0 +1,441 @@
+#include "arguments.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+namespace {
+    bool
+    is_space
+    (char const c) noexcept {
+	return c == ' ' || c == '\t';
+    };
+
+    char const*
+    type_name
+    (ConsoleWriter::ArgumentType const type) noexcept {
+	switch (type) {
+	case ConsoleWriter::ArgumentType::INTEGER:
+	    return "integer";
+	case ConsoleWriter::ArgumentType::NUMBER:
+	    return "number";
+	case ConsoleWriter::ArgumentType::DURATION:
+	    return "duration";
+	default:
+	    return "string";
+	};
+    };
+
+    // calls emit(begin, end, quoted) for every token in line
+    template <typename Emit>
+    void
+    tokenize
+    (std::string_view line, Emit&& emit) {
+	size_t i = 0;
+	while (i < line.size()) {
+	    while (i < line.size() && is_space(line[i])) {
+		++i;
+	    };
+	    if (i == line.size()) {
+		break;
+	    };
+	    if (line[i] == '"' || line[i] == '\'') {
+		const size_t close = line.find(line[i], i + 1);
+		const size_t end = close == std::string_view::npos ?
+		    line.size() : close;
+		emit(i + 1, end, true);
+		i = end + 1;
+		continue;
+	    };
+	    const size_t begin = i;
+	    while (i < line.size() && !is_space(line[i])) {
+		++i;
+	    };
+	    emit(begin, i, false);
+	};
+    };
+};
+
+ConsoleWriter::Arguments::Arguments
+(std::string_view line)
+    : _line(line) {
+    size_t count = 0;
+    tokenize(_line, [&] (size_t, size_t, bool) { ++count; });
+    _positional.reserve(count);
+
+    tokenize(_line, [&] (size_t const begin, size_t const end,
+			 bool const quoted) {
+	Token token {};
+	token._offset = static_cast<uint32_t>(begin);
+	token._length = static_cast<uint32_t>(end - begin);
+	const std::string_view word = text(token);
+	if (quoted || word.size() <= 2 || word.substr(0, 2) != "--") {
+	    _positional.push_back(token);
+	    return;
+	};
+	Named named {};
+	const size_t equals = word.find('=');
+	named._name._offset = token._offset + 2;
+	named._name._length = static_cast<uint32_t>
+	    ((equals == std::string_view::npos ? word.size() : equals) - 2);
+	named._has_value = equals != std::string_view::npos;
+	if (named._has_value) {
+	    named._value._offset = token._offset +
+		static_cast<uint32_t>(equals) + 1;
+	    named._value._length = token._length -
+		static_cast<uint32_t>(equals) - 1;
+	};
+	_named.push_back(named);
+    });
+};
+
+std::string_view
+ConsoleWriter::Arguments::operator[]
+(size_t const index) const noexcept {
+    return index < _positional.size() ? text(_positional[index]) :
+	std::string_view();
+};
+
+std::optional<int64_t>
+ConsoleWriter::Arguments::integer
+(Token const& token) const noexcept {
+    if (token._type == ArgumentType::INTEGER) {
+	return token._integer;
+    };
+    return parse_integer(text(token));
+};
+
+std::optional<double>
+ConsoleWriter::Arguments::number
+(Token const& token) const noexcept {
+    if (token._type == ArgumentType::NUMBER) {
+	return token._number;
+    } else if (token._type == ArgumentType::INTEGER) {
+	return static_cast<double>(token._integer);
+    };
+    return parse_number(text(token));
+};
+
+std::optional<ConsoleWriter::Arguments::Duration>
+ConsoleWriter::Arguments::duration
+(Token const& token) const noexcept {
+    if (token._type == ArgumentType::DURATION) {
+	return Duration(token._integer);
+    };
+    return parse_duration(text(token));
+};
+
+std::optional<int64_t>
+ConsoleWriter::Arguments::integer
+(size_t const index) const noexcept {
+    if (index >= _positional.size()) {
+	return std::nullopt;
+    };
+    return integer(_positional[index]);
+};
+
+std::optional<double>
+ConsoleWriter::Arguments::number
+(size_t const index) const noexcept {
+    if (index >= _positional.size()) {
+	return std::nullopt;
+    };
+    return number(_positional[index]);
+};
+
+std::optional<ConsoleWriter::Arguments::Duration>
+ConsoleWriter::Arguments::duration
+(size_t const index) const noexcept {
+    if (index >= _positional.size()) {
+	return std::nullopt;
+    };
+    return duration(_positional[index]);
+};
+
+ConsoleWriter::Arguments::Named const*
+ConsoleWriter::Arguments::find_named
+(std::string_view name) const noexcept {
+    for (Named const& named : _named) {
+	if (text(named._name) == name) {
+	    return &named;
+	};
+    };
+    return nullptr;
+};
+
+bool
+ConsoleWriter::Arguments::flag
+(std::string_view name) const noexcept {
+    Named const* named = find_named(name);
+    return named && !named->_has_value;
+};
+
+ConsoleWriter::Arguments::Token const*
+ConsoleWriter::Arguments::find_option
+(std::string_view name) const noexcept {
+    Named const* named = find_named(name);
+    return named && named->_has_value ? &named->_value : nullptr;
+};
+
+std::optional<std::string_view>
+ConsoleWriter::Arguments::option
+(std::string_view name) const noexcept {
+    Token const* value = find_option(name);
+    if (!value) {
+	return std::nullopt;
+    };
+    return text(*value);
+};
+
+std::optional<int64_t>
+ConsoleWriter::Arguments::option_integer
+(std::string_view name) const noexcept {
+    Token const* value = find_option(name);
+    if (!value) {
+	return std::nullopt;
+    };
+    return integer(*value);
+};
+
+std::optional<double>
+ConsoleWriter::Arguments::option_number
+(std::string_view name) const noexcept {
+    Token const* value = find_option(name);
+    if (!value) {
+	return std::nullopt;
+    };
+    return number(*value);
+};
+
+std::optional<ConsoleWriter::Arguments::Duration>
+ConsoleWriter::Arguments::option_duration
+(std::string_view name) const noexcept {
+    Token const* value = find_option(name);
+    if (!value) {
+	return std::nullopt;
+    };
+    return duration(*value);
+};
+
+std::optional<int64_t>
+ConsoleWriter::Arguments::parse_integer
+(std::string_view text) noexcept {
+    if (!text.empty() && text.front() == '+') {
+	text.remove_prefix(1);
+    };
+    int64_t value = 0;
+    const char* end = text.data() + text.size();
+    const auto result = std::from_chars(text.data(), end, value);
+    if (text.empty() || result.ec != std::errc() || result.ptr != end) {
+	return std::nullopt;
+    };
+    return value;
+};
+
+std::optional<double>
+ConsoleWriter::Arguments::parse_number
+(std::string_view text) noexcept {
+    if (!text.empty() && text.front() == '+') {
+	text.remove_prefix(1);
+    };
+    double value = 0.0;
+    const char* end = text.data() + text.size();
+    const auto result = std::from_chars(text.data(), end, value);
+    if (text.empty() || result.ec != std::errc() || result.ptr != end) {
+	return std::nullopt;
+    };
+    return value;
+};
+
+std::optional<ConsoleWriter::Arguments::Duration>
+ConsoleWriter::Arguments::parse_duration
+(std::string_view text) noexcept {
+    size_t split = text.size();
+    while (split > 0 && std::isalpha(static_cast<unsigned char>
+				     (text[split - 1]))) {
+	--split;
+    };
+    const std::string_view unit = text.substr(split);
+    double scale = 0.0;
+    if (unit.empty() || unit == "s") {
+	scale = 1e9;
+    } else if (unit == "ns") {
+	scale = 1.0;
+    } else if (unit == "us") {
+	scale = 1e3;
+    } else if (unit == "ms") {
+	scale = 1e6;
+    } else if (unit == "m") {
+	scale = 60e9;
+    } else if (unit == "h") {
+	scale = 3600e9;
+    } else {
+	return std::nullopt;
+    };
+    const auto value = parse_number(text.substr(0, split));
+    if (!value || *value < 0.0) {
+	return std::nullopt;
+    };
+    // nanoseconds past int64_t cannot be converted
+    const double nanoseconds = *value * scale;
+    if (!std::isfinite(nanoseconds) ||
+	nanoseconds >= static_cast<double>
+	(std::numeric_limits<int64_t>::max())) {
+	return std::nullopt;
+    };
+    return Duration(static_cast<int64_t>(nanoseconds));
+};
+
+ConsoleWriter::ArgumentSchema&
+ConsoleWriter::ArgumentSchema::required
+(std::string name, ArgumentType const type) {
+    // required arguments always come before optional ones
+    _positional.insert(_positional.begin() + _required,
+		       Parameter { std::move(name), type, false });
+    ++_required;
+    return *this;
+};
+
+ConsoleWriter::ArgumentSchema&
+ConsoleWriter::ArgumentSchema::optional
+(std::string name, ArgumentType const type) {
+    _positional.push_back(Parameter { std::move(name), type, false });
+    return *this;
+};
+
+ConsoleWriter::ArgumentSchema&
+ConsoleWriter::ArgumentSchema::variadic
+(std::string name, ArgumentType const type, size_t const minimum) {
+    _variadic = Parameter { std::move(name), type, false };
+    _variadic_minimum = minimum;
+    return *this;
+};
+
+ConsoleWriter::ArgumentSchema&
+ConsoleWriter::ArgumentSchema::flag
+(std::string name) {
+    _named.push_back(Parameter { std::move(name), ArgumentType::STRING,
+				 true });
+    return *this;
+};
+
+ConsoleWriter::ArgumentSchema&
+ConsoleWriter::ArgumentSchema::option
+(std::string name, ArgumentType const type) {
+    _named.push_back(Parameter { std::move(name), type, false });
+    return *this;
+};
+
+bool
+ConsoleWriter::ArgumentSchema::convert
+(Arguments const& arguments, Arguments::Token& token,
+ ArgumentType const type) noexcept {
+    const std::string_view text = arguments.text(token);
+    switch (type) {
+    case ArgumentType::INTEGER: {
+	const auto value = Arguments::parse_integer(text);
+	if (!value) {
+	    return false;
+	};
+	token._integer = *value;
+	break;
+    }
+    case ArgumentType::NUMBER: {
+	const auto value = Arguments::parse_number(text);
+	if (!value) {
+	    return false;
+	};
+	token._number = *value;
+	break;
+    }
+    case ArgumentType::DURATION: {
+	const auto value = Arguments::parse_duration(text);
+	if (!value) {
+	    return false;
+	};
+	token._integer = value->count();
+	break;
+    }
+    default:
+	break;
+    };
+    token._type = type;
+    return true;
+};
+
+std::string
+ConsoleWriter::ArgumentSchema::bind
+(Arguments& arguments) const {
+    std::stringstream ss;
+    const size_t count = arguments._positional.size();
+    const size_t minimum = _variadic && _variadic_minimum > 0 ?
+	_positional.size() + _variadic_minimum : _required;
+    if (count < minimum) {
+	ss << "expected at least " << minimum << " argument"
+	   << (minimum == 1 ? "" : "s") << ", got " << count;
+	return ss.str();
+    } else if (!_variadic && count > _positional.size()) {
+	ss << "expected at most " << _positional.size() << " argument"
+	   << (_positional.size() == 1 ? "" : "s") << ", got " << count;
+	return ss.str();
+    };
+    for (size_t i = 0; i < count; ++i) {
+	Parameter const& parameter = i < _positional.size() ?
+	    _positional[i] : *_variadic;
+	if (!convert(arguments, arguments._positional[i], parameter._type)) {
+	    ss << parameter._name << ": \""
+	       << arguments.text(arguments._positional[i])
+	       << "\" is not a valid " << type_name(parameter._type);
+	    return ss.str();
+	};
+    };
+    for (auto& named : arguments._named) {
+	const std::string_view name = arguments.text(named._name);
+	const auto it = std::find_if
+	    (_named.begin(), _named.end(), [&] (Parameter const& p) {
+		return p._name == name && p._flag != named._has_value;
+	    });
+	if (it == _named.end()) {
+	    ss << "unknown " << (named._has_value ? "option" : "flag")
+	       << " --" << name;
+	    return ss.str();
+	};
+	if (named._has_value &&
+	    !convert(arguments, named._value, it->_type)) {
+	    ss << "--" << name << ": \"" << arguments.text(named._value)
+	       << "\" is not a valid " << type_name(it->_type);
+	    return ss.str();
+	};
+    };
+    return std::string();
+};
+
+std::string
+ConsoleWriter::ArgumentSchema::usage
+() const {
+    std::stringstream ss;
+    for (size_t i = 0; i < _positional.size(); ++i) {
+	ss << (i ? " " : "") << (i < _required ? "<" : "[")
+	   << _positional[i]._name << (i < _required ? ">" : "]");
+    };
+    if (_variadic) {
+	ss << (_positional.empty() ? "" : " ") << "<" << _variadic->_name
+	   << "...>";
+    };
+    for (Parameter const& named : _named) {
+	if (named._flag) {
+	    ss << " [--" << named._name << "]";
+	} else {
+	    ss << " [--" << named._name << "=<" << type_name(named._type)
+	       << ">]";
+	};
+    };
+    std::string usage = ss.str();
+    if (!usage.empty() && usage.front() == ' ') {
+	usage.erase(0, 1);
+    };
+    return usage;
+};
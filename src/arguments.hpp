@@ -0,0 +1,133 @@
+#ifndef CLASS_ARGUMENTS
+#define CLASS_ARGUMENTS
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ConsoleWriter {
+    enum class ArgumentType : uint8_t {
+	STRING,
+	INTEGER,
+	NUMBER,
+	// a number with an optional unit: ns, us, ms, s (default), m or h
+	DURATION
+    };
+
+    // A command line split into positional arguments, --flags and
+    // --name=value options.
+    //
+    // Tokens are kept as offsets into one copy of the line, so splitting
+    // never allocates per token and the arguments can be moved to a worker
+    // thread. Single or double quotes group words; there are no escapes.
+    // Once a schema has bound the arguments, typed reads return the value
+    // parsed during validation instead of parsing again.
+    class Arguments {
+    public:
+	using Duration = std::chrono::nanoseconds;
+
+	explicit Arguments(std::string_view line);
+
+	size_t size() const noexcept { return _positional.size(); }
+	bool empty() const noexcept { return _positional.empty(); }
+	std::string_view line() const noexcept { return _line; }
+	std::string_view operator[](size_t const index) const noexcept;
+
+	std::optional<int64_t> integer(size_t const index) const noexcept;
+	std::optional<double> number(size_t const index) const noexcept;
+	std::optional<Duration> duration(size_t const index) const noexcept;
+
+	bool flag(std::string_view name) const noexcept;
+	std::optional<std::string_view> option(std::string_view name)
+	    const noexcept;
+	// --name=value, as bound; nullopt when absent or not of the type
+	std::optional<int64_t> option_integer(std::string_view name)
+	    const noexcept;
+	std::optional<double> option_number(std::string_view name)
+	    const noexcept;
+	std::optional<Duration> option_duration(std::string_view name)
+	    const noexcept;
+
+	static std::optional<int64_t> parse_integer(std::string_view text)
+	    noexcept;
+	static std::optional<double> parse_number(std::string_view text)
+	    noexcept;
+	static std::optional<Duration> parse_duration(std::string_view text)
+	    noexcept;
+    private:
+	friend class ArgumentSchema;
+
+	struct Token {
+	    uint32_t _offset;
+	    uint32_t _length;
+	    ArgumentType _type { ArgumentType::STRING };
+	    union {
+		int64_t _integer;
+		double _number;
+	    };
+	};
+
+	struct Named {
+	    Token _name;
+	    Token _value;
+	    bool _has_value;
+	};
+
+	std::string_view text(Token const& token) const noexcept {
+	    return std::string_view(_line).substr(token._offset,
+						  token._length);
+	}
+	Named const* find_named(std::string_view name) const noexcept;
+	Token const* find_option(std::string_view name) const noexcept;
+	// the value bound by a schema, or parsed from the text
+	std::optional<int64_t> integer(Token const& token) const noexcept;
+	std::optional<double> number(Token const& token) const noexcept;
+	std::optional<Duration> duration(Token const& token) const noexcept;
+
+	std::string _line;
+	std::vector<Token> _positional;
+	std::vector<Named> _named;
+    };
+
+    // What a command accepts, checked once before it is dispatched:
+    //
+    //     ArgumentSchema().required("count", ArgumentType::INTEGER)
+    //                     .option("every", ArgumentType::DURATION)
+    //                     .flag("quiet")
+    class ArgumentSchema {
+    public:
+	ArgumentSchema& required(std::string name, ArgumentType const type);
+	ArgumentSchema& optional(std::string name, ArgumentType const type);
+	// any number of trailing arguments of one type, at least minimum
+	ArgumentSchema& variadic(std::string name, ArgumentType const type,
+				 size_t const minimum = 0);
+	ArgumentSchema& flag(std::string name);
+	ArgumentSchema& option(std::string name, ArgumentType const type);
+
+	// parses every argument to its declared type; returns an error
+	// message, or an empty string when the arguments fit
+	std::string bind(Arguments& arguments) const;
+	std::string usage() const;
+    private:
+	struct Parameter {
+	    std::string _name;
+	    ArgumentType _type;
+	    bool _flag;
+	};
+
+	static bool convert(Arguments const& arguments,
+			    Arguments::Token& token, ArgumentType const type)
+	    noexcept;
+
+	std::vector<Parameter> _positional;
+	size_t _required { 0 };
+	std::optional<Parameter> _variadic;
+	size_t _variadic_minimum { 0 };
+	std::vector<Parameter> _named;
+    };
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include "channel.hpp"
+
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    struct Channels {
+	std::mutex _lock;
+	std::unordered_map<std::string, ConsoleWriter::Channel> _ids;
+	std::vector<std::string> _names { "main" };
+
+	Channels() { _ids.emplace("main", ConsoleWriter::MAIN_CHANNEL); }
+    };
+
+    // leaked, so producers outliving main can still name channels
+    Channels&
+    channels
+    () {
+	static Channels* channels = new Channels();
+	return *channels;
+    };
+
+    thread_local ConsoleWriter::Channel _thread_channel {
+	ConsoleWriter::MAIN_CHANNEL };
+};
+
+ConsoleWriter::Channel
+ConsoleWriter::channel
+(std::string_view name) {
+    Channels& registry = channels();
+    std::scoped_lock<std::mutex> lock(registry._lock);
+    const auto found = registry._ids.find(std::string(name));
+    if (found != registry._ids.end()) {
+	return found->second;
+    };
+    if (registry._names.size() > std::numeric_limits<Channel>::max()) {
+	throw std::length_error("too many console channels");
+    };
+    const Channel id = static_cast<Channel>(registry._names.size());
+    registry._names.emplace_back(name);
+    registry._ids.emplace(std::string(name), id);
+    return id;
+};
+
+std::string
+ConsoleWriter::channel_name
+(Channel const channel) {
+    Channels& registry = channels();
+    std::scoped_lock<std::mutex> lock(registry._lock);
+    return channel < registry._names.size() ? registry._names[channel] :
+	std::to_string(channel);
+};
+
+void
+ConsoleWriter::set_thread_channel
+(Channel const channel) noexcept {
+    _thread_channel = channel;
+};
+
+ConsoleWriter::Channel
+ConsoleWriter::thread_channel
+() noexcept {
+    return _thread_channel;
+};
@@ -0,0 +1,29 @@
+#ifndef NAMESPACE_CHANNEL
+#define NAMESPACE_CHANNEL
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ConsoleWriter {
+    // A named stream of messages, e.g. one per ThreadedProcess. Names are
+    // interned once, so a message carries a two-byte id and the console
+    // can route it to the panes showing that channel.
+    using Channel = uint16_t;
+
+    // untagged messages, from threads without a channel of their own
+    constexpr Channel MAIN_CHANNEL { 0 };
+
+    // the same name always gives the same channel; throws
+    // std::length_error past 65535 names. Thread safe
+    Channel channel(std::string_view name);
+    std::string channel_name(Channel const channel);
+
+    // messages this thread adds without a channel are tagged with
+    // channel, e.g. set_thread_channel(channel(process_name())) at the
+    // top of a process's thread
+    void set_thread_channel(Channel const channel) noexcept;
+    Channel thread_channel() noexcept;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef CLASS_COMMAND
+#define CLASS_COMMAND
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "arguments.hpp"
+
+namespace ConsoleWriter {
+    struct Command {
+	// commands run on the console's worker pool unless run_inline is
+	// set, which is meant for quick commands that report on the console
+	// itself and must answer even when every worker is busy
+	Command(std::string&& description,
+		std::function<std::string(std::string const&)>&& callback,
+		bool const run_inline = false) {
+	    _description = std::move(description);
+	    _callback = std::move(callback);
+	    _run_inline = run_inline;
+	};
+	// the console splits and checks the arguments against the schema
+	// before dispatch, so the callback only ever sees arguments that fit
+	Command(std::string&& description,
+		ArgumentSchema schema,
+		std::function<std::string(Arguments const&)>&& callback,
+		bool const run_inline = false) {
+	    _description = std::move(description);
+	    _schema = std::make_shared<const ArgumentSchema>
+		(std::move(schema));
+	    _typed_callback = std::move(callback);
+	    _callback = [schema = _schema, typed = _typed_callback]
+		(std::string const& line) {
+		    Arguments arguments(line);
+		    const std::string error = schema->bind(arguments);
+		    return error.empty() ? typed(arguments) : error;
+		};
+	    _run_inline = run_inline;
+	};
+	std::string _description;
+	std::function<std::string(std::string const&)> _callback;
+	std::shared_ptr<const ArgumentSchema> _schema;
+	std::function<std::string(Arguments const&)> _typed_callback;
+	bool _run_inline;
+    };
+};
+
+#endif
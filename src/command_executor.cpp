@@ -0,0 +1,141 @@
+#include "command_executor.hpp"
+
+#include <exception>
+
+namespace {
+    thread_local std::shared_ptr<std::atomic<bool>> _current_flag;
+};
+
+ConsoleWriter::CancellationToken
+ConsoleWriter::current_cancellation_token
+() noexcept {
+    return CancellationToken(_current_flag);
+};
+
+bool
+ConsoleWriter::cancellation_requested
+() noexcept {
+    return _current_flag && _current_flag->load(std::memory_order_relaxed);
+};
+
+ConsoleWriter::CommandExecutor::CommandExecutor
+(size_t const workers) {
+    const size_t count = workers > 0 ? workers : 1;
+    _workers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+	_workers.emplace_back([this] () { run_worker(); });
+    };
+};
+
+ConsoleWriter::CommandExecutor::~CommandExecutor
+() {
+    {
+	std::scoped_lock<std::mutex> lock(_lock);
+	_stopping = true;
+	for (auto& entry : _jobs) {
+	    entry.second->_cancelled->store(true);
+	};
+    }
+    _work_ready.notify_all();
+    for (auto& worker : _workers) {
+	worker.join();
+    };
+};
+
+uint64_t
+ConsoleWriter::CommandExecutor::submit
+(std::string command, Task&& task, Completion&& on_complete) {
+    auto job = std::make_shared<Job>();
+    job->_command = std::move(command);
+    job->_task = std::move(task);
+    job->_on_complete = std::move(on_complete);
+    job->_cancelled = std::make_shared<std::atomic<bool>>(false);
+    job->_submitted = Clock::now();
+    uint64_t id;
+    {
+	std::scoped_lock<std::mutex> lock(_lock);
+	id = job->_id = _next_id++;
+	_jobs.emplace(id, job);
+	_queue.push_back(std::move(job));
+    }
+    _work_ready.notify_one();
+    return id;
+};
+
+bool
+ConsoleWriter::CommandExecutor::cancel
+(uint64_t const id) {
+    std::scoped_lock<std::mutex> lock(_lock);
+    const auto it = _jobs.find(id);
+    if (it == _jobs.end()) {
+	return false;
+    };
+    it->second->_cancelled->store(true);
+    return true;
+};
+
+std::vector<ConsoleWriter::CommandExecutor::JobInfo>
+ConsoleWriter::CommandExecutor::jobs
+() const {
+    const auto now = Clock::now();
+    std::vector<JobInfo> result;
+    std::scoped_lock<std::mutex> lock(_lock);
+    result.reserve(_jobs.size());
+    for (auto const& entry : _jobs) {
+	result.push_back(info(*entry.second, now));
+    };
+    return result;
+};
+
+ConsoleWriter::CommandExecutor::JobInfo
+ConsoleWriter::CommandExecutor::info
+(Job const& job, Clock::time_point const now) const {
+    return JobInfo { job._id, job._command, job._running,
+		     job._cancelled->load(),
+		     now - (job._running ? job._started : job._submitted) };
+};
+
+void
+ConsoleWriter::CommandExecutor::run_worker
+() {
+    while (true) {
+	std::shared_ptr<Job> job;
+	{
+	    std::unique_lock<std::mutex> lock(_lock);
+	    _work_ready.wait(lock, [&] () {
+		return _stopping || !_queue.empty();
+	    });
+	    if (_queue.empty()) {
+		return;
+	    };
+	    job = std::move(_queue.front());
+	    _queue.pop_front();
+	    job->_running = true;
+	    job->_started = Clock::now();
+	}
+
+	// a job cancelled while queued completes without running
+	std::string result;
+	if (!job->_cancelled->load()) {
+	    _current_flag = job->_cancelled;
+	    try {
+		result = job->_task();
+	    } catch (std::exception const& e) {
+		result = std::string("Command failed: ") + e.what();
+	    } catch (...) {
+		result = "Command failed.";
+	    };
+	    _current_flag = nullptr;
+	};
+
+	JobInfo finished;
+	{
+	    std::scoped_lock<std::mutex> lock(_lock);
+	    finished = info(*job, Clock::now());
+	    _jobs.erase(job->_id);
+	}
+	if (job->_on_complete) {
+	    job->_on_complete(finished, result);
+	};
+    };
+};
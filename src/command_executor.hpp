@@ -0,0 +1,91 @@
+#ifndef CLASS_COMMAND_EXECUTOR
+#define CLASS_COMMAND_EXECUTOR
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ConsoleWriter {
+    // Cooperative cancellation flag shared between a job and whoever may
+    // cancel it. Long-running commands should poll it and return early.
+    class CancellationToken {
+    public:
+	CancellationToken() = default;
+	explicit CancellationToken(std::shared_ptr<std::atomic<bool>> flag)
+	    : _flag(std::move(flag)) {}
+
+	bool cancelled() const noexcept {
+	    return _flag && _flag->load(std::memory_order_relaxed);
+	}
+    private:
+	std::shared_ptr<std::atomic<bool>> _flag;
+    };
+
+    // The token of the command running on the calling thread, so callbacks
+    // registered with the plain Command signature can still be cancelled.
+    CancellationToken current_cancellation_token() noexcept;
+    bool cancellation_requested() noexcept;
+
+    // Runs console commands on a fixed pool of worker threads so a slow
+    // command never holds up keystroke handling or rendering.
+    class CommandExecutor {
+    public:
+	using Clock = std::chrono::steady_clock;
+
+	struct JobInfo {
+	    uint64_t _id;
+	    std::string _command;
+	    bool _running;
+	    bool _cancelled;
+	    Clock::duration _elapsed;
+	};
+
+	using Task = std::function<std::string()>;
+	using Completion = std::function<void(JobInfo const& job,
+					      std::string const& result)>;
+
+	explicit CommandExecutor(size_t const workers);
+	~CommandExecutor();
+
+	CommandExecutor(CommandExecutor const& other) = delete;
+	CommandExecutor &operator=(CommandExecutor const& other) = delete;
+
+	uint64_t submit(std::string command, Task&& task,
+			Completion&& on_complete);
+	bool cancel(uint64_t const id);
+	std::vector<JobInfo> jobs() const;
+    private:
+	struct Job {
+	    uint64_t _id;
+	    std::string _command;
+	    Task _task;
+	    Completion _on_complete;
+	    std::shared_ptr<std::atomic<bool>> _cancelled;
+	    bool _running { false };
+	    Clock::time_point _submitted;
+	    Clock::time_point _started;
+	};
+
+	void run_worker();
+	JobInfo info(Job const& job, Clock::time_point const now) const;
+
+	mutable std::mutex _lock;
+	std::condition_variable _work_ready;
+	std::deque<std::shared_ptr<Job>> _queue;
+	std::unordered_map<uint64_t, std::shared_ptr<Job>> _jobs;
+	uint64_t _next_id { 1 };
+	bool _stopping { false };
+	std::vector<std::thread> _workers;
+    };
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "command_registry.hpp"
+
+#include <algorithm>
+
+namespace {
+    template <typename Node>
+    auto
+    find_child
+    (Node& node, char const c) noexcept {
+	return std::lower_bound(node._children.begin(), node._children.end(),
+				c, [] (auto const& child, char const key) {
+				    return child.first < key;
+				});
+    };
+};
+
+ConsoleWriter::CommandRegistry::CommandRegistry
+() {
+    auto root = std::make_shared<const Node>();
+    _root.store(root.get(), std::memory_order_release);
+    _roots.push_back(std::move(root));
+};
+
+void
+ConsoleWriter::CommandRegistry::add
+(std::string_view name, CommandPtr const& command) {
+    std::scoped_lock<std::mutex> lock(_writer_lock);
+    auto root = insert(_root.load(std::memory_order_relaxed), name, command);
+    _root.store(root.get(), std::memory_order_release);
+    _roots.push_back(std::move(root));
+};
+
+std::shared_ptr<const ConsoleWriter::CommandRegistry::Node>
+ConsoleWriter::CommandRegistry::insert
+(Node const* node, std::string_view name, CommandPtr const& command) {
+    auto copy = node ? std::make_shared<Node>(*node) :
+	std::make_shared<Node>();
+    if (name.empty()) {
+	if (!copy->_command) {
+	    ++copy->_count;
+	};
+	copy->_command = command;
+	return copy;
+    };
+    auto it = find_child(*copy, name.front());
+    Node const* child = nullptr;
+    if (it != copy->_children.end() && it->first == name.front()) {
+	child = it->second.get();
+    } else {
+	it = copy->_children.emplace(it, name.front(), nullptr);
+    };
+    const size_t before = child ? child->_count : 0;
+    it->second = insert(child, name.substr(1), command);
+    copy->_count += it->second->_count - before;
+    return copy;
+};
+
+ConsoleWriter::CommandRegistry::Node const*
+ConsoleWriter::CommandRegistry::Snapshot::descend
+(std::string_view prefix) const noexcept {
+    Node const* node = _root;
+    for (char const c : prefix) {
+	if (!node) {
+	    return nullptr;
+	};
+	const auto it = find_child(*node, c);
+	if (it == node->_children.end() || it->first != c) {
+	    return nullptr;
+	};
+	node = it->second.get();
+    };
+    return node;
+};
+
+ConsoleWriter::CommandRegistry::CommandPtr
+ConsoleWriter::CommandRegistry::Snapshot::find
+(std::string_view name) const noexcept {
+    Node const* node = descend(name);
+    return node ? node->_command : nullptr;
+};
+
+ConsoleWriter::CommandRegistry::Lookup
+ConsoleWriter::CommandRegistry::Snapshot::resolve
+(std::string_view name) const {
+    Node const* node = descend(name);
+    if (!node || node->_count == 0) {
+	return Lookup { Match::NOT_FOUND, std::string(name), nullptr };
+    };
+    if (node->_command) {
+	return Lookup { Match::EXACT, std::string(name), node->_command };
+    };
+    if (node->_count > 1) {
+	return Lookup { Match::AMBIGUOUS, std::string(name), nullptr };
+    };
+    std::string full(name);
+    while (!node->_command) {
+	// a subtree holding one command is a single chain down to it
+	full.push_back(node->_children.front().first);
+	node = node->_children.front().second.get();
+    };
+    return Lookup { Match::UNIQUE_PREFIX, std::move(full), node->_command };
+};
+
+std::string
+ConsoleWriter::CommandRegistry::Snapshot::common_prefix
+(std::string_view prefix) const {
+    Node const* node = descend(prefix);
+    std::string common(prefix);
+    if (!node) {
+	return common;
+    };
+    while (!node->_command && node->_children.size() == 1) {
+	common.push_back(node->_children.front().first);
+	node = node->_children.front().second.get();
+    };
+    return common;
+};
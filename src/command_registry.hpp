@@ -0,0 +1,116 @@
+#ifndef CLASS_COMMAND_REGISTRY
+#define CLASS_COMMAND_REGISTRY
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "command.hpp"
+
+namespace ConsoleWriter {
+    // Command names in a persistent prefix trie.
+    //
+    // Registration copies only the path to the new name and publishes the
+    // new root with a single atomic store; readers load the root once and
+    // walk an immutable snapshot, so dispatch never takes a lock and never
+    // sees a half-made change. Replaced roots are retired rather than
+    // freed (registration is rare and they share all untouched nodes), so
+    // a snapshot stays valid for the life of the registry.
+    class CommandRegistry {
+    public:
+	using CommandPtr = std::shared_ptr<const Command>;
+
+	struct Node {
+	    CommandPtr _command;
+	    // sorted by character
+	    std::vector<std::pair<char, std::shared_ptr<const Node>>> _children;
+	    size_t _count { 0 };
+	};
+
+	enum class Match {
+	    EXACT,
+	    UNIQUE_PREFIX,
+	    AMBIGUOUS,
+	    NOT_FOUND
+	};
+
+	struct Lookup {
+	    Match _match;
+	    std::string _name;
+	    CommandPtr _command;
+	};
+
+	class Snapshot {
+	public:
+	    explicit Snapshot(Node const* root) : _root(root) {}
+
+	    CommandPtr find(std::string_view name) const noexcept;
+	    // exact name first, otherwise a prefix of exactly one command
+	    Lookup resolve(std::string_view name) const;
+	    // longest extension of prefix shared by every matching command
+	    std::string common_prefix(std::string_view prefix) const;
+	    size_t size() const noexcept { return _root ? _root->_count : 0; }
+
+	    // visit(name, command) for every command under prefix, in order
+	    template <typename Visitor>
+	    void for_each(std::string_view prefix, Visitor&& visit) const;
+	private:
+	    Node const* descend(std::string_view prefix) const noexcept;
+	    template <typename Visitor>
+	    static void walk(Node const* node, std::string& name,
+			     Visitor& visit);
+
+	    Node const* _root;
+	};
+
+	CommandRegistry();
+
+	CommandRegistry(CommandRegistry const& other) = delete;
+	CommandRegistry &operator=(CommandRegistry const& other) = delete;
+
+	void add(std::string_view name, CommandPtr const& command);
+	Snapshot snapshot() const noexcept {
+	    return Snapshot(_root.load(std::memory_order_acquire));
+	}
+    private:
+	static std::shared_ptr<const Node>
+	insert(Node const* node, std::string_view name,
+	       CommandPtr const& command);
+
+	std::atomic<Node const*> _root { nullptr };
+	std::mutex _writer_lock;
+	std::vector<std::shared_ptr<const Node>> _roots;
+    };
+};
+
+template <typename Visitor>
+void
+ConsoleWriter::CommandRegistry::Snapshot::for_each
+(std::string_view prefix, Visitor&& visit) const {
+    Node const* node = descend(prefix);
+    if (!node) {
+	return;
+    };
+    std::string name(prefix);
+    walk(node, name, visit);
+};
+
+template <typename Visitor>
+void
+ConsoleWriter::CommandRegistry::Snapshot::walk
+(Node const* node, std::string& name, Visitor& visit) {
+    if (node->_command) {
+	visit(std::string_view(name), node->_command);
+    };
+    for (auto const& child : node->_children) {
+	name.push_back(child.first);
+	walk(child.second.get(), name, visit);
+	name.pop_back();
+    };
+};
+
+#endif
@@ -1,67 +1,101 @@
 #include "console.hpp"
 
-#include <ctime>
 #include <chrono>
 #include <sstream>
-#include <ncurses.h>
 #include <iostream>
 #include <cstring>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
 
 namespace ConsoleWriter {
     std::shared_ptr<ConsoleInterface> _console { nullptr };
     const std::string ConsoleInterface::_acceptable_characters =
 	" abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!\""
 	"£$%^&*()+-=_[]{}@:;'#~?/|.,<>\\";
+    constexpr std::string_view ERROR_TAG { "[ERROR]" };
+    constexpr std::string_view LEVEL_TAGS[] {
+	"[TRACE]", "[DEBUG]", "[INFO]", "[WARNING]"
+    };
+
+    std::string
+    format_duration
+    (std::chrono::steady_clock::duration const elapsed) {
+	const double micros = std::chrono::duration<double, std::micro>
+	    (elapsed).count();
+	std::stringstream ss;
+	ss.precision(3);
+	if (micros < 1000.0) {
+	    ss << micros << " us";
+	} else if (micros < 1000000.0) {
+	    ss << micros / 1000.0 << " ms";
+	} else {
+	    ss << micros / 1000000.0 << " s";
+	};
+	return ss.str();
+    };
 };
 
 void
 ConsoleWriter::timestamped_message
 (std::string const& message) noexcept {
-    ConsoleInterface::Message msg;
-    msg.add_chunk(timestamp(true), ConsoleInterface::Message::TIMESTAMP);
-    msg.add_chunk(message, ConsoleInterface::Message::NORMAL);
-#if DEBUG
-    for (auto const& st : msg._strs) {
-	std::cout << st;
-    };
-    std::cout<< "\n";
-#else
-    _console->add_message(std::move(msg));
-#endif
+    timestamped_message(MAIN_CHANNEL, message);
 };
 
 void
 ConsoleWriter::error_message
 (std::string const& message) noexcept {
-    ConsoleInterface::Message msg;
-    msg.add_chunk(timestamp(true), ConsoleInterface::Message::TIMESTAMP);
-    msg.add_chunk("[ERROR]", ConsoleInterface::Message::ERROR);
-    msg.add_chunk(message, ConsoleInterface::Message::NORMAL);
-#if DEBUG
-    auto &s = msg._strs;
-    for (auto const& st : s) {
-	std::cout << st;
+    error_message(MAIN_CHANNEL, message);
+};
+
+void
+ConsoleWriter::log_message
+(LogLevel const level, Channel const channel,
+ std::string const& message) noexcept {
+    if (level >= LogLevel::ERROR) {
+	error_message(channel, message);
+	return;
     };
-    std::cout<< "\n";
-#else
+    const std::string_view tag = LEVEL_TAGS[static_cast<size_t>(level)];
+    ConsoleInterface::Message msg(tag.size() + message.size());
+    msg.stamp();
+    msg.add_chunk(tag, level == LogLevel::WARNING ?
+		  ConsoleInterface::Message::ERROR :
+		  ConsoleInterface::Message::HIGHLIGHT);
+    msg.add_chunk(message, ConsoleInterface::Message::NORMAL);
+    msg._channel = channel;
+    _console->add_message(std::move(msg));
+};
+
+void
+ConsoleWriter::timestamped_message
+(Channel const channel, std::string const& message) noexcept {
+    ConsoleInterface::Message msg(message.size());
+    msg.stamp();
+    msg.add_chunk(message, ConsoleInterface::Message::NORMAL);
+    msg._channel = channel;
     _console->add_message(std::move(msg));
-#endif
+};
+
+void
+ConsoleWriter::error_message
+(Channel const channel, std::string const& message) noexcept {
+    ConsoleInterface::Message msg(ERROR_TAG.size() + message.size());
+    msg.stamp();
+    msg.add_chunk(ERROR_TAG, ConsoleInterface::Message::ERROR);
+    msg.add_chunk(message, ConsoleInterface::Message::NORMAL);
+    msg._channel = channel;
+    _console->add_error_message(std::move(msg));
+};
+
+std::string
+ConsoleWriter::in_colour
+(const std::string &message, const std::string &colour) noexcept {
+    return colour + message + ESC::reset;
 };
 
 std::string ConsoleWriter::timestamp(const bool padded) noexcept {
-    const time_t curr_time = time(NULL);
-    char buff[32];
-    strftime(buff, 20, "%Y-%m-%d %H:%M:%S", localtime(&curr_time));
-    std::string time_str(&(buff[0]), 20);
-    time_str.erase(std::find(time_str.begin(), time_str.end(), '\0'),
-	      time_str.end());
-    std::stringstream ss;
-    if (padded) {
-    	ss <<  '[' << time_str << ']';
-    } else {
-	ss << time_str;
-    };
-    return ss.str();
+    return Timestamp::to_string(Timestamp::now(), padded);
 };
 
 bool ConsoleWriter::can_shutdown() {
@@ -103,174 +137,1065 @@ ConsoleWriter::add_command
 // Terminal class
 
 std::shared_ptr<ConsoleWriter::ConsoleInterface>
-ConsoleWriter::ConsoleInterface::create() {
-    ConsoleWriter::_console = std::make_shared<ConsoleInterface>();
-    _console->_user_entry_thread =
-	std::make_unique<std::thread>(std::bind
-				      (&ConsoleInterface::run_user_input,
-				       std::ref(*_console)));
+ConsoleWriter::ConsoleInterface::create
+(std::unique_ptr<Renderer> renderer, ConsoleOptions const& options) {
+    ConsoleWriter::_console = std::make_shared<ConsoleInterface>
+	(std::move(renderer), options);
+    if (_console->_renderer->accepts_input()) {
+	_console->_user_entry_thread =
+	    std::make_unique<std::thread>(std::bind
+					  (&ConsoleInterface::run_user_input,
+					   std::ref(*_console)));
+    };
     return ConsoleWriter::_console;
 };
 
-ConsoleWriter::ConsoleInterface::ConsoleInterface() 
-    : ThreadedProcess(0)
-    , _current_index(0) {
-    initscr();
-    curs_set(0);
-    start_color();
-    init_pair(Message::HIGHLIGHT, COLOR_BLACK, COLOR_WHITE);
-    init_pair(Message::NORMAL, COLOR_WHITE, COLOR_BLACK);
-    init_pair(Message::INPUT, COLOR_MAGENTA, COLOR_BLACK);
-    init_pair(Message::TIMESTAMP, COLOR_CYAN, COLOR_BLACK);
-    init_pair(Message::ERROR, COLOR_RED, COLOR_BLACK);
-    keypad(stdscr, TRUE);
-    noecho();
+ConsoleWriter::ConsoleInterface::ConsoleInterface
+(std::unique_ptr<Renderer> renderer, ConsoleOptions const& options)
+    : ThreadedProcess()
+    , _message_queue(options._queue_capacity)
+    , _error_queue(options._error_lane_capacity)
+    , _overflow_policy(options._overflow_policy)
+    , _sample_every(options._sample_every > 0 ? options._sample_every : 1)
+    , _filter_settings(options._filter)
+    , _execution_mode(options._execution_mode)
+    , _latency_samples(LATENCY_SAMPLES, 0.0)
+    , _started(std::chrono::steady_clock::now())
+    , _rate_previous { _started, 0, 0 }
+    , _rate_current { _started, 0, 0 }
+    , _status_board(std::make_shared<StatusBoard>()) {
+    set_max_frame_rate(DEFAULT_FRAME_RATE);
+    _status_board->set_waker([this] () { wake(); });
+    _pane_settings.push_back(PaneSettings { "all", {} });
+    _panes.emplace_back(PaneSettings { "all", {} },
+			DEFAULT_SCROLLBACK_LINES);
+    _filter.configure(_filter_settings);
+    if (options._thread_buffers) {
+	_producer_rings = std::make_unique<ProducerRings>
+	    (options._thread_buffer_capacity);
+    };
+    if (!renderer) {
+	renderer = make_renderer(default_render_backend());
+    };
+    _renderer = std::move(renderer);
+    _page_rows = std::max(_renderer->log_rows(0) - 1, 1);
+    _executor = std::make_unique<CommandExecutor>(COMMAND_WORKERS);
     _terminal_running = true;
-    print_separator();
-    print_input_buffer();
     add_default_commands();
-    this->start();
+    launch();
 };
 
 ConsoleWriter::ConsoleInterface::~ConsoleInterface() {
+    // widget handles can outlive the console
+    _status_board->set_waker(nullptr);
     _terminal_running = false;
-    _user_entry_thread->join();
-    _thread->join();
-    refresh();
-    endwin();
+    // cancels whatever is still running and waits for the workers
+    _executor.reset();
+    if (_user_entry_thread) {
+	_user_entry_thread->join();
+    };
+    join();
+    _renderer.reset();
     std::cout << "goodbye world.\n";
 };
 
 void ConsoleWriter::ConsoleInterface::start() {
+    if (_execution_mode == ExecutionMode::COOPERATIVE) {
+	_running = true;
+	start_cooperative();
+	return;
+    };
     _thread = std::make_shared<std::thread>
 	([&]( ) { this->run_console(); });
 };
 
-void ConsoleWriter::ConsoleInterface::add_message(Message const& message) {
-    std::scoped_lock<std::mutex> local_mutex(_msg_lock);
-    _message_queue.emplace(message);
+template <typename Push>
+void
+ConsoleWriter::ConsoleInterface::park_producer
+(Push&& pushed) noexcept {
+    _blocked.fetch_add(1, std::memory_order_relaxed);
+    _parked_producers.fetch_add(1);
+    std::unique_lock<std::mutex> lock(_room_lock);
+    // the timeout re-wakes a console that missed the first wake
+    while (!pushed()) {
+	wake();
+	_room.wait_for(lock, std::chrono::milliseconds(10));
+    };
+    _parked_producers.fetch_sub(1);
+};
+
+bool ConsoleWriter::ConsoleInterface::add_message(Message&& message) {
+    _enqueued.add();
+    if (!message.has_timestamp()) {
+	message._enqueued = Timestamp::now();
+    };
+    if (message._source == 0) {
+	message._source = Message::current_source();
+    };
+    if (message._channel == MAIN_CHANNEL) {
+	message._channel = thread_channel();
+    };
+    const OverflowPolicy policy =
+	_overflow_policy.load(std::memory_order_relaxed);
+    if (_producer_rings) {
+	return push_to_thread_buffer(std::move(message), policy);
+    };
+    if (policy == OverflowPolicy::SAMPLE &&
+	_message_queue.size_approx() >= _message_queue.capacity() / 4 * 3) {
+	const size_t every = _sample_every.load(std::memory_order_relaxed);
+	if (_overflow_count.fetch_add(1, std::memory_order_relaxed) %
+	    every != 0) {
+	    _sampled_out.fetch_add(1, std::memory_order_relaxed);
+	    return false;
+	};
+    };
+    if (!_message_queue.try_push(std::move(message))) {
+	switch (policy) {
+	case OverflowPolicy::BLOCK: {
+	    park_producer([&] () {
+		return _message_queue.try_push(std::move(message));
+	    });
+	    break;
+	}
+	case OverflowPolicy::DROP_OLDEST: {
+	    do {
+		Message oldest;
+		if (_message_queue.try_pop(oldest)) {
+		    _dropped_oldest.fetch_add(1, std::memory_order_relaxed);
+		} else {
+		    std::this_thread::yield();
+		};
+	    } while (!_message_queue.try_push(std::move(message)));
+	    break;
+	}
+	case OverflowPolicy::SAMPLE: {
+	    _sampled_out.fetch_add(1, std::memory_order_relaxed);
+	    return false;
+	}
+	default: {
+	    _dropped_newest.fetch_add(1, std::memory_order_relaxed);
+	    return false;
+	};
+	};
+    };
+    wake();
+    return true;
+};
+
+bool
+ConsoleWriter::ConsoleInterface::push_to_thread_buffer
+(Message&& message, OverflowPolicy const policy) noexcept {
+    ProducerRings::Ring& ring = _producer_rings->local();
+    if (policy == OverflowPolicy::SAMPLE &&
+	ring.size_approx() >= ring.capacity() / 4 * 3) {
+	// per thread, so sampling never touches a shared counter
+	thread_local size_t overflow_count = 0;
+	if (overflow_count++ % _sample_every.load
+	    (std::memory_order_relaxed) != 0) {
+	    _sampled_out.fetch_add(1, std::memory_order_relaxed);
+	    return false;
+	};
+    };
+    if (!ring.try_push(std::move(message))) {
+	if (policy == OverflowPolicy::BLOCK) {
+	    park_producer([&] () {
+		return ring.try_push(std::move(message));
+	    });
+	} else if (policy == OverflowPolicy::SAMPLE) {
+	    _sampled_out.fetch_add(1, std::memory_order_relaxed);
+	    return false;
+	} else {
+	    _dropped_newest.fetch_add(1, std::memory_order_relaxed);
+	    return false;
+	};
+    };
+    wake();
+    return true;
+};
+
+void
+ConsoleWriter::ConsoleInterface::add_error_message
+(Message&& message) {
+    _enqueued.add();
+    if (!message.has_timestamp()) {
+	message._enqueued = Timestamp::now();
+    };
+    if (message._source == 0) {
+	message._source = Message::current_source();
+    };
+    if (message._channel == MAIN_CHANNEL) {
+	message._channel = thread_channel();
+    };
+    if (!_error_queue.try_push(std::move(message))) {
+	wake();
+	_error_queue.push(std::move(message));
+    };
+    wake();
+};
+
+void
+ConsoleWriter::ConsoleInterface::set_overflow_policy
+(OverflowPolicy const policy, size_t const sample_every) noexcept {
+    _sample_every.store(sample_every > 0 ? sample_every : 1,
+			std::memory_order_relaxed);
+    _overflow_policy.store(policy, std::memory_order_relaxed);
+};
+
+ConsoleWriter::ConsoleInterface::QueueReport
+ConsoleWriter::ConsoleInterface::queue_report
+() const noexcept {
+    QueueReport report;
+    report._capacity = _message_queue.capacity();
+    report._queued = _message_queue.size_approx();
+    report._errors_queued = _error_queue.size_approx();
+    report._thread_buffers =
+	_thread_buffer_count.load(std::memory_order_relaxed);
+    report._policy = _overflow_policy.load(std::memory_order_relaxed);
+    report._sample_every = _sample_every.load(std::memory_order_relaxed);
+    report._blocked = _blocked.load(std::memory_order_relaxed);
+    report._dropped_newest = _dropped_newest.load(std::memory_order_relaxed);
+    report._dropped_oldest = _dropped_oldest.load(std::memory_order_relaxed);
+    report._sampled_out = _sampled_out.load(std::memory_order_relaxed);
+    return report;
+};
+
+size_t
+ConsoleWriter::ConsoleInterface::dropped_messages
+() const noexcept {
+    return _dropped_newest.load(std::memory_order_relaxed) +
+	_dropped_oldest.load(std::memory_order_relaxed) +
+	_sampled_out.load(std::memory_order_relaxed);
+};
+
+void ConsoleWriter::ConsoleInterface::wake() noexcept {
+    if (_task) {
+	resume();
+	return;
+    };
+    // pairs with the fence in wait_for_messages: either the console thread
+    // sees the new message or this thread sees it going to sleep
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_sleeping.load(std::memory_order_relaxed)) {
+	std::scoped_lock<std::mutex> lock(_wake_lock);
+	_wake_cv.notify_one();
+    };
+};
+
+void ConsoleWriter::ConsoleInterface::on_shutdown() noexcept {
+    std::scoped_lock<std::mutex> lock(_wake_lock);
+    _wake_cv.notify_all();
+};
+
+void ConsoleWriter::ConsoleInterface::wait_for_messages() {
+    std::unique_lock<std::mutex> lock(_wake_lock);
+    _sleeping.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto ready = [&] () {
+	return !_message_queue.empty() || !_error_queue.empty() ||
+	    (_producer_rings && !_producer_rings->empty()) ||
+	    _input_dirty || _view_dirty || _panes_dirty ||
+	    _status_board->pending() || !_running;
+    };
+    // wake up in time to report messages the filter has held back and to
+    // refresh decaying status rows
+    const auto deadline = next_deadline();
+    if (deadline == Timestamp::Clock::time_point::max()) {
+	_wake_cv.wait(lock, ready);
+    } else {
+	_wake_cv.wait_until(lock, deadline, ready);
+    };
+    _sleeping.store(false, std::memory_order_relaxed);
 };
 
 void ConsoleWriter::ConsoleInterface::run_console() {
+    using namespace std::chrono;
     _running = true;
+    steady_clock::time_point last_frame;
     while (_running) {
-	std::this_thread::sleep_for(std::chrono::milliseconds(50));
-	while (!_message_queue.empty()) {
-	    send_next_message();
+	wait_for_messages();
+	// hold the frame back until the interval has passed so a burst of
+	// messages is drawn together rather than one frame each
+	const nanoseconds interval(_min_frame_interval_ns.load());
+	const auto next_frame = last_frame + interval;
+	if (steady_clock::now() < next_frame) {
+	    std::this_thread::sleep_until(next_frame);
 	};
+	last_frame = steady_clock::now();
+	render_frame();
     };
+    render_frame();
     send_shutdown_message();
-    _deletable = true;
+    set_deletable();
+};
+
+// the body of run_console's loop, for COOPERATIVE mode: every wake()
+// resumes it, and the frame cap and filter deadlines become timers
+bool ConsoleWriter::ConsoleInterface::run_once() {
+    using namespace std::chrono;
+    if (_deletable) {
+	return false;
+    };
+    if (!_running) {
+	render_frame();
+	send_shutdown_message();
+	set_deletable();
+	return false;
+    };
+    const auto now = steady_clock::now();
+    const auto next_frame = _last_frame +
+	nanoseconds(_min_frame_interval_ns.load());
+    if (now < next_frame) {
+	resume_at(next_frame);
+	return false;
+    };
+    _last_frame = now;
+    render_frame();
+    const auto deadline = next_deadline();
+    if (deadline != Timestamp::Clock::time_point::max()) {
+	resume_at(deadline);
+    };
+    return false;
+};
+
+void
+ConsoleWriter::ConsoleInterface::set_max_frame_rate
+(unsigned int const frames_per_second) noexcept {
+    const int64_t interval = frames_per_second == 0 ? 0 :
+	1000000000 / static_cast<int64_t>(frames_per_second);
+    _min_frame_interval_ns.store(interval);
+};
+
+void ConsoleWriter::ConsoleInterface::render_frame() noexcept {
+    const auto frame_start = std::chrono::steady_clock::now();
+    _frame_enqueue_times.clear();
+    {
+	// stage every pending line and the input row, then write the
+	// terminal once
+	std::scoped_lock<std::mutex> lock(_print_lock);
+	// new panes first, so this frame's messages reach them
+	if (_panes_dirty.exchange(false)) {
+	    apply_pane_changes();
+	};
+	send_pending_messages();
+	if (_view_dirty.exchange(false)) {
+	    apply_view_changes();
+	};
+	draw_status_widgets();
+	draw_status();
+	if (_input_dirty.exchange(false)) {
+	    draw_input_buffer();
+	};
+	_renderer->present();
+    }
+    _frame_time.record(static_cast<uint64_t>(
+	std::chrono::duration_cast<std::chrono::nanoseconds>
+	(std::chrono::steady_clock::now() - frame_start).count()));
+    _frame_batch.record(_frame_enqueue_times.size());
+    _frames.add();
+    record_frame_latencies();
+};
+
+void ConsoleWriter::ConsoleInterface::record_frame_latencies() noexcept {
+    if (_frame_enqueue_times.empty()) {
+	return;
+    };
+    // the frame is on screen now, so one clock read covers every message
+    const auto now = std::chrono::steady_clock::now();
+    for (auto const& enqueued : _frame_enqueue_times) {
+	_latency_histogram.record(static_cast<uint64_t>(
+	    std::chrono::duration_cast<std::chrono::nanoseconds>
+	    (now - enqueued).count()));
+    };
+    // the histogram covers start-up onwards; the ring keeps the recent
+    // window exact
+    std::scoped_lock<std::mutex> lock(_latency_lock);
+    for (auto const& enqueued : _frame_enqueue_times) {
+	_latency_samples[_latency_index % LATENCY_SAMPLES] =
+	    std::chrono::duration<double, std::micro>(now - enqueued).count();
+	++_latency_index;
+    };
+};
+
+void
+ConsoleWriter::ConsoleInterface::set_log_sink
+(std::shared_ptr<LogSink> sink) {
+    std::scoped_lock<std::mutex> lock(_print_lock);
+    _log_sink = std::move(sink);
+};
+
+void
+ConsoleWriter::ConsoleInterface::set_scrollback_capacity
+(size_t const lines) noexcept {
+    _scrollback_request = lines > 0 ? lines : 1;
+    _view_dirty = true;
+    wake();
+};
+
+void
+ConsoleWriter::ConsoleInterface::scroll_log
+(int64_t const lines) noexcept {
+    _scroll_request += lines;
+    _view_dirty = true;
+    wake();
+};
+
+void ConsoleWriter::ConsoleInterface::apply_view_changes() noexcept {
+    const size_t capacity = _scrollback_request.exchange(0);
+    if (capacity != 0 && capacity != _panes.front()._history.capacity()) {
+	for (size_t i = 0; i < _panes.size(); ++i) {
+	    _panes[i]._history.set_capacity
+		(i == 0 ? capacity :
+		 std::min(capacity, CHANNEL_SCROLLBACK_LINES));
+	    redraw_pane(i);
+	};
+    };
+    // scrolling moves the focused pane only
+    Pane& pane = _panes[_focus];
+    bool redraw = false;
+    if (_scroll_to_bottom.exchange(false) && pane._scroll_offset != 0) {
+	pane._scroll_offset = 0;
+	redraw = true;
+    };
+    const int64_t delta = _scroll_request.exchange(0);
+    const size_t rows = static_cast<size_t>
+	(_renderer->log_rows(slot_of(_focus)));
+    const size_t max_offset = pane._history.size() > rows ?
+	pane._history.size() - rows : 0;
+    int64_t offset = static_cast<int64_t>(pane._scroll_offset) + delta;
+    offset = std::clamp<int64_t>(offset, 0,
+				 static_cast<int64_t>(max_offset));
+    if (static_cast<size_t>(offset) != pane._scroll_offset || redraw) {
+	pane._scroll_offset = static_cast<size_t>(offset);
+	redraw_pane(_focus);
+    };
+};
+
+bool
+ConsoleWriter::ConsoleInterface::Pane::shows
+(Channel const channel) const noexcept {
+    auto const& channels = _settings._channels;
+    return channels.empty() ||
+	std::find(channels.begin(), channels.end(), channel) !=
+	channels.end();
 };
 
-std::string ConsoleWriter::ConsoleInterface::current_buffer_string() noexcept {
+size_t
+ConsoleWriter::ConsoleInterface::slot_of
+(size_t const pane) const noexcept {
+    return pane >= _first_shown && pane < _first_shown + _shown ?
+	pane - _first_shown : NOT_SHOWN;
+};
+
+void
+ConsoleWriter::ConsoleInterface::redraw_pane
+(size_t const index) noexcept {
+    const size_t slot = slot_of(index);
+    if (slot == NOT_SHOWN) {
+	return;
+    };
+    Pane const& pane = _panes[index];
+    _renderer->draw_log_page(slot, pane._history,
+			     pane._history.size() - pane._scroll_offset);
+};
+
+void ConsoleWriter::ConsoleInterface::apply_pane_changes() {
+    std::vector<PaneSettings> settings;
+    {
+	std::scoped_lock<std::mutex> lock(_pane_lock);
+	settings = _pane_settings;
+	_focus = _pane_focus;
+	_split = _split_panes;
+    }
+    // panes that survive keep their history
+    std::vector<Pane> panes;
+    panes.reserve(settings.size());
+    const size_t capacity = std::min(_panes.front()._history.capacity(),
+				     CHANNEL_SCROLLBACK_LINES);
+    for (auto& wanted : settings) {
+	const auto found = std::find_if
+	    (_panes.begin(), _panes.end(), [&] (Pane const& pane) {
+		return pane._settings._name == wanted._name;
+	    });
+	if (found != _panes.end()) {
+	    found->_settings = std::move(wanted);
+	    panes.push_back(std::move(*found));
+	} else {
+	    panes.emplace_back(std::move(wanted), capacity);
+	};
+    };
+    _panes = std::move(panes);
+    _focus = std::min(_focus, _panes.size() - 1);
+    layout_panes();
+};
+
+void ConsoleWriter::ConsoleInterface::layout_panes() noexcept {
+    const size_t wanted = _split ? _panes.size() : 1;
+    _shown = std::max<size_t>(std::min(wanted, _renderer->max_panes()), 1);
+    // keep the focused pane on screen
+    _first_shown = !_split ? _focus :
+	_focus >= _shown ? _focus - _shown + 1 : 0;
+    _renderer->set_panes(_shown);
+    for (size_t i = _first_shown; i < _first_shown + _shown; ++i) {
+	redraw_pane(i);
+	if (_shown == 1) {
+	    continue;
+	};
+	std::string title = (i == _focus ? "> " : "  ") +
+	    _panes[i]._settings._name + ":";
+	if (_panes[i]._settings._channels.empty()) {
+	    title += " every channel";
+	};
+	for (const Channel channel : _panes[i]._settings._channels) {
+	    title += " " + channel_name(channel);
+	};
+	_renderer->draw_pane_title(slot_of(i), title);
+    };
+    _page_rows = std::max(_renderer->log_rows(slot_of(_focus)) - 1, 1);
+    // the separator names the focused pane
+    _drawn_focus = NOT_SHOWN;
+};
+
+bool
+ConsoleWriter::ConsoleInterface::add_pane
+(std::string name, std::vector<Channel> channels) {
+    {
+	std::scoped_lock<std::mutex> lock(_pane_lock);
+	for (auto const& pane : _pane_settings) {
+	    if (pane._name == name) {
+		return false;
+	    };
+	};
+	_pane_settings.push_back(PaneSettings { std::move(name),
+						std::move(channels) });
+    }
+    _panes_dirty = true;
+    wake();
+    return true;
+};
+
+bool
+ConsoleWriter::ConsoleInterface::set_pane_channels
+(std::string const& name, std::vector<Channel> channels) {
+    {
+	std::scoped_lock<std::mutex> lock(_pane_lock);
+	const auto found = std::find_if
+	    (_pane_settings.begin() + 1, _pane_settings.end(),
+	     [&] (PaneSettings const& pane) { return pane._name == name; });
+	if (found == _pane_settings.end()) {
+	    return false;
+	};
+	found->_channels = std::move(channels);
+    }
+    _panes_dirty = true;
+    wake();
+    return true;
+};
+
+bool
+ConsoleWriter::ConsoleInterface::remove_pane
+(std::string const& name) {
+    {
+	std::scoped_lock<std::mutex> lock(_pane_lock);
+	const auto found = std::find_if
+	    (_pane_settings.begin() + 1, _pane_settings.end(),
+	     [&] (PaneSettings const& pane) { return pane._name == name; });
+	if (found == _pane_settings.end()) {
+	    return false;
+	};
+	const size_t index = static_cast<size_t>
+	    (found - _pane_settings.begin());
+	_pane_settings.erase(found);
+	if (_pane_focus >= index && _pane_focus > 0) {
+	    --_pane_focus;
+	};
+    }
+    _panes_dirty = true;
+    wake();
+    return true;
+};
+
+bool
+ConsoleWriter::ConsoleInterface::focus_pane
+(std::string const& name) {
+    {
+	std::scoped_lock<std::mutex> lock(_pane_lock);
+	const auto found = std::find_if
+	    (_pane_settings.begin(), _pane_settings.end(),
+	     [&] (PaneSettings const& pane) { return pane._name == name; });
+	if (found == _pane_settings.end()) {
+	    return false;
+	};
+	_pane_focus = static_cast<size_t>(found - _pane_settings.begin());
+    }
+    _panes_dirty = true;
+    wake();
+    return true;
+};
+
+void
+ConsoleWriter::ConsoleInterface::cycle_pane_focus
+(int const step) {
+    {
+	std::scoped_lock<std::mutex> lock(_pane_lock);
+	const int64_t count = static_cast<int64_t>(_pane_settings.size());
+	const int64_t focus = static_cast<int64_t>(_pane_focus) + step;
+	_pane_focus = static_cast<size_t>(((focus % count) + count) % count);
+    }
+    _panes_dirty = true;
+    wake();
+};
+
+void
+ConsoleWriter::ConsoleInterface::set_split_panes
+(bool const split) {
+    {
+	std::scoped_lock<std::mutex> lock(_pane_lock);
+	_split_panes = split;
+    }
+    _panes_dirty = true;
+    wake();
+};
+
+ConsoleWriter::ConsoleInterface::PaneReport
+ConsoleWriter::ConsoleInterface::panes
+() const {
+    std::scoped_lock<std::mutex> lock(_pane_lock);
+    return PaneReport { _pane_settings, _pane_focus, _split_panes };
+};
+
+void ConsoleWriter::ConsoleInterface::draw_status_widgets() noexcept {
+    // however many updates landed since the last frame, each changed row
+    // is formatted and drawn once here
+    const auto now = StatusBoard::Clock::now();
+    if (!_status_board->pending() && now < _status_board->next_refresh()) {
+	return;
+    };
+    const size_t rows = _status_board->rows();
+    const bool resized = rows != _status_rows;
+    if (resized) {
+	_status_rows = rows;
+	_renderer->set_status_rows(rows);
+	// fewer panes may fit now
+	layout_panes();
+    };
+    _status_board->refresh(static_cast<size_t>(_renderer->columns()), now,
+			   resized,
+			   [&] (size_t const row, std::string const& text) {
+			       _renderer->draw_status_row(row, text);
+			   });
+};
+
+std::chrono::steady_clock::time_point
+ConsoleWriter::ConsoleInterface::next_deadline
+() const noexcept {
+    return std::min(_filter.next_flush(), _status_board->next_refresh());
+};
+
+void ConsoleWriter::ConsoleInterface::draw_status() noexcept {
+    const size_t dropped = dropped_messages();
+    Pane const& pane = _panes[_focus];
+    if (pane._scroll_offset == _drawn_scroll_offset &&
+	_focus == _drawn_focus && dropped == _drawn_dropped) {
+	return;
+    };
+    _drawn_scroll_offset = pane._scroll_offset;
+    _drawn_focus = _focus;
+    _drawn_dropped = dropped;
     std::stringstream ss;
-    for (const auto &c : _input_buffer) {
-	ss << c;
+    if (_panes.size() > 1) {
+	ss << " pane " << pane._settings._name << " (" << _focus + 1
+	   << "/" << _panes.size() << ") ";
+    };
+    if (pane._scroll_offset != 0) {
+	ss << " scrollback: " << pane._scroll_offset << " of "
+	   << pane._history.size() << " lines up ";
+    };
+    if (dropped != 0) {
+	ss << " dropped: " << dropped << " ";
     };
+    _renderer->draw_separator(ss.str());
+};
+
+ConsoleWriter::ConsoleInterface::LatencyReport
+ConsoleWriter::ConsoleInterface::render_latency
+() const {
+    std::vector<double> samples;
+    LatencyReport report {};
+    {
+	std::scoped_lock<std::mutex> lock(_latency_lock);
+	const size_t count = std::min(_latency_index, LATENCY_SAMPLES);
+	samples.assign(_latency_samples.begin(),
+		       _latency_samples.begin() + count);
+    }
+    const Histogram::Snapshot totals = _latency_histogram.snapshot();
+    const Numerical::Statistics<double> stats = totals.statistics();
+    report._total_samples = totals._count;
+    report._mean_us = stats._mean / 1000.0;
+    report._std_dev_us = stats._std_dev / 1000.0;
+    report._max_us = stats._max / 1000.0;
+    report._total_p99_us = totals.quantile(0.99) / 1000.0;
+    report._samples = samples.size();
+    if (samples.empty()) {
+	return report;
+    };
+    const auto p50 = samples.begin() + samples.size() / 2;
+    std::nth_element(samples.begin(), p50, samples.end());
+    report._p50_us = *p50;
+    const auto p99 = samples.begin() + (samples.size() * 99) / 100;
+    std::nth_element(samples.begin(), p99, samples.end());
+    report._p99_us = *p99;
+    return report;
+};
+
+ConsoleWriter::ConsoleInterface::MetricsReport
+ConsoleWriter::ConsoleInterface::metrics
+() const {
+    using namespace std::chrono;
+    MetricsReport report {};
+    const auto now = steady_clock::now();
+    report._uptime_s = duration<double>(now - _started).count();
+    report._enqueued = _enqueued.value();
+    report._rendered = _rendered.value();
+    report._frames = _frames.value();
+    {
+	// rates run from a sample at least a second old, so polling
+	// faster than that never divides by a sliver of time
+	std::scoped_lock<std::mutex> lock(_rate_lock);
+	if (now - _rate_current._time >= seconds(1)) {
+	    _rate_previous = _rate_current;
+	    _rate_current = { now, report._enqueued, report._rendered };
+	};
+	const double elapsed =
+	    duration<double>(now - _rate_previous._time).count();
+	if (elapsed > 0.0) {
+	    report._enqueue_rate = static_cast<double>
+		(report._enqueued - _rate_previous._enqueued) / elapsed;
+	    report._render_rate = static_cast<double>
+		(report._rendered - _rate_previous._rendered) / elapsed;
+	};
+    }
+    report._queue_depth = _message_queue.size_approx() +
+	_error_queue.size_approx();
+    report._dropped = dropped_messages();
+    report._collapsed = _filter_collapsed.load(std::memory_order_relaxed);
+    report._rate_limited =
+	_filter_rate_limited.load(std::memory_order_relaxed);
+    report._latency = _latency_histogram.snapshot();
+    report._frame_time = _frame_time.snapshot();
+    report._frame_batch = _frame_batch.snapshot();
+    std::scoped_lock<std::mutex> lock(_command_time_lock);
+    for (auto const& [name, histogram] : _command_time) {
+	report._command_time.emplace(name, histogram->snapshot());
+    };
+    return report;
+};
+
+std::string
+ConsoleWriter::ConsoleInterface::metrics_json
+() const {
+    const MetricsReport report = metrics();
+    std::stringstream ss;
+    ss << "{\"uptime_s\":" << report._uptime_s
+       << ",\"enqueued\":" << report._enqueued
+       << ",\"rendered\":" << report._rendered
+       << ",\"frames\":" << report._frames
+       << ",\"enqueue_rate\":" << report._enqueue_rate
+       << ",\"render_rate\":" << report._render_rate
+       << ",\"queue_depth\":" << report._queue_depth
+       << ",\"dropped\":" << report._dropped
+       << ",\"collapsed\":" << report._collapsed
+       << ",\"rate_limited\":" << report._rate_limited
+       << ",\"latency_us\":";
+    report._latency.write_json(ss, 1000.0);
+    ss << ",\"frame_time_us\":";
+    report._frame_time.write_json(ss, 1000.0);
+    ss << ",\"frame_batch\":";
+    report._frame_batch.write_json(ss, 1.0);
+    ss << ",\"commands_us\":{";
+    bool first = true;
+    for (auto const& [name, snapshot] : report._command_time) {
+	if (!first) {
+	    ss << ",";
+	};
+	first = false;
+	write_json_string(ss, name);
+	ss << ":";
+	snapshot.write_json(ss, 1000.0);
+    };
+    ss << "}}";
     return ss.str();
 };
 
 void ConsoleWriter::ConsoleInterface::send_shutdown_message() noexcept {
     Message msg;
-    msg.add_chunk(timestamp(true), Message::TIMESTAMP);
+    msg.stamp();
     msg.add_chunk("Console shut down.", Message::NORMAL);
-    std::scoped_lock<std::mutex> lock(_msg_lock);
-    print_line(_sent_messages.size(), std::move(msg));
+    std::scoped_lock<std::mutex> lock(_print_lock);
+    // a supervised sink is only shut down after the console
+    if (_log_sink) {
+	_log_sink->write(msg);
+    };
+    print_message(std::move(msg));
+    _renderer->present();
 }
 
-void ConsoleWriter::ConsoleInterface::send_next_message() noexcept {
-    if (_message_queue.empty())
-	return;
-    std::scoped_lock<std::mutex> lock(_msg_lock);
-    print_line(_sent_messages.size(), std::move(_message_queue.front()));
-    _message_queue.pop();
+void ConsoleWriter::ConsoleInterface::send_pending_messages() noexcept {
+    // drain everything queued so far in one claim per queue, errors first
+    // so they are never stuck behind a backlog
+    if (_filter_dirty.exchange(false)) {
+	std::scoped_lock<std::mutex> lock(_filter_lock);
+	_filter.configure(_filter_settings);
+    };
+    const auto now = Timestamp::now();
+    auto show = [&] (Message&& msg) {
+	_rendered.add();
+	if (_log_sink) {
+	    _log_sink->write(msg);
+	};
+	print_message(std::move(msg));
+    };
+    // only what reaches the screen counts towards latency and batch
+    // size, not what the filter collapses or rate limits
+    _error_queue.pop_batch([&] (Message&& msg) {
+	if (_filter.admit(msg, false, now)) {
+	    _frame_enqueue_times.push_back(msg._enqueued);
+	    show(std::move(msg));
+	};
+    });
+    auto admit = [&] (Message&& msg) {
+	if (_filter.admit(msg, true, now)) {
+	    _frame_enqueue_times.push_back(msg._enqueued);
+	    show(std::move(msg));
+	};
+    };
+    if (_producer_rings) {
+	_producer_rings->merge(admit);
+	_thread_buffer_count.store(_producer_rings->rings(),
+				   std::memory_order_relaxed);
+    };
+    _message_queue.pop_batch(admit);
+    if (_parked_producers.load() > 0) {
+	std::scoped_lock<std::mutex> lock(_room_lock);
+	_room.notify_all();
+    };
+    _filter.flush(now, show);
+    _filter_collapsed.store(_filter.collapsed(), std::memory_order_relaxed);
+    _filter_rate_limited.store(_filter.rate_limited(),
+			       std::memory_order_relaxed);
+};
+
+void
+ConsoleWriter::ConsoleInterface::set_message_filter
+(MessageFilter::Settings const& settings) {
+    {
+	std::scoped_lock<std::mutex> lock(_filter_lock);
+	_filter_settings = settings;
+    }
+    _filter_dirty = true;
+    wake();
+};
+
+ConsoleWriter::MessageFilter::Settings
+ConsoleWriter::ConsoleInterface::message_filter
+() const {
+    std::scoped_lock<std::mutex> lock(_filter_lock);
+    return _filter_settings;
 };
 
 void ConsoleWriter::ConsoleInterface::run_user_input() {
+    std::vector<int> keys;
     while (_terminal_running) {
-	handle_input(static_cast<KeyPress>(getch()));
+	// time out so the loop notices the terminal closing
+	if (!_renderer->wait_for_key(INPUT_POLL_MS)) {
+	    continue;
+	};
+	keys.clear();
+	{
+	    std::scoped_lock<std::mutex> lock(_print_lock);
+	    int key = _renderer->read_key();
+	    while (key != Renderer::NO_KEY) {
+		keys.push_back(key);
+		key = _renderer->read_key();
+	    };
+	}
+	handle_keys(keys);
+    };
+};
+
+void
+ConsoleWriter::ConsoleInterface::handle_keys
+(std::vector<int> const& keys) {
+    // runs of typed or pasted characters go into the editor in one insert
+    std::string typed;
+    for (int const key : keys) {
+	if (key > 0 && key < 256 && key != KeyPress::ENTER &&
+	    key != KeyPress::DEL && key != KeyPress::TAB &&
+	    key != KeyPress::NEXT_PANE && key != KeyPress::PREVIOUS_PANE &&
+	    key != KeyPress::SPLIT_PANES) {
+	    typed.push_back(static_cast<char>(key));
+	    continue;
+	};
+	add_characters(typed);
+	typed.clear();
+	handle_input(key);
     };
+    add_characters(typed);
+    print_input_buffer();
 };
 
 void ConsoleWriter::ConsoleInterface::handle_input(int const input) {
     switch (input) {
     case KeyPress::LEFT:
     case KeyPress::RIGHT:
+    case KeyPress::HOME:
+    case KeyPress::END: {
+	std::scoped_lock<std::mutex> lock(_input_lock);
+	move_index(input);
+	break;
+    }
     case KeyPress::UP:
     case KeyPress::DOWN: {
-	move_index(input);
+	std::scoped_lock<std::mutex> lock(_input_lock);
+	recall_command(input);
+	break;
+    }
+    case KeyPress::SCROLL_UP:
+    case KeyPress::SCROLL_DOWN:
+    case KeyPress::PAGE_UP:
+    case KeyPress::PAGE_DOWN: {
+	scroll_view(input);
 	break;
     }
-    case KeyPress::BACKSPACE: {
-	remove_character();
+    case KeyPress::BACKSPACE:
+    case KeyPress::DEL:
+    case KeyPress::DELETE: {
+	std::scoped_lock<std::mutex> lock(_input_lock);
+	remove_character(input);
 	break;
     }
     case KeyPress::ENTER: {
 	execute_message();
 	break;
     }
+    case KeyPress::TAB: {
+	complete_command();
+	break;
+    }
+    case KeyPress::NEXT_PANE:
+    case KeyPress::PREVIOUS_PANE: {
+	cycle_pane_focus(input == KeyPress::NEXT_PANE ? 1 : -1);
+	break;
+    }
+    case KeyPress::SPLIT_PANES: {
+	set_split_panes(!panes()._split);
+	break;
+    }
     default: {
-	add_character(static_cast<char>(input));
+	if (input > 0 && input < 256) {
+	    add_characters(std::string(1, static_cast<char>(input)));
+	};
 	break;
     };
     };
-    print_input_buffer();
 };
 
-void ConsoleWriter::ConsoleInterface::remove_character() {
-    if (_current_index == 0 || _input_buffer.empty() ||
-	_current_index > _input_buffer.size()) {
-	return;
+void ConsoleWriter::ConsoleInterface::remove_character(int const key) {
+    if (key == KeyPress::DELETE) {
+	_editor.erase_after();
+    } else {
+	_editor.erase_before();
     };
-    _current_index--;
-    auto it = _input_buffer.begin();
-    std::advance(it, _current_index);
-    _input_buffer.erase(it);
-    print_input_buffer();
 };
 
 void ConsoleWriter::ConsoleInterface::execute_message() {
-    std::stringstream ss;
-    for (const auto &c : _input_buffer) {
-	ss << c;
-    };
-    Message msg;
-    msg.add_chunk(timestamp(true), Message::TIMESTAMP);
+    std::string command;
+    {
+	std::scoped_lock<std::mutex> lock(_input_lock);
+	command = _editor.commit();
+    }
+    Message msg(command.size() + 1);
+    msg.stamp();
     msg.add_chunk(">", Message::INPUT);
-    msg.add_chunk(ss.str(), Message::NORMAL);
-    print_line(_sent_messages.size(), std::move(msg));
-    handle_command(ss.str());
-    _input_buffer.clear();
-    _current_index = 0;
-    print_input_buffer();
+    msg.add_chunk(command, Message::NORMAL);
+    // running a command jumps back to the live end of the log
+    _scroll_to_bottom = true;
+    _view_dirty = true;
+    // echo through the queue so only the console thread touches the history
+    add_message(std::move(msg));
+    handle_command(command);
 };
 
-void ConsoleWriter::ConsoleInterface::add_character(char const input) {
-    if (_acceptable_characters.find(input) == std::string::npos) {
+void
+ConsoleWriter::ConsoleInterface::complete_command
+() {
+    // only the command name completes, and only up to the cursor
+    std::string prefix;
+    {
+	std::scoped_lock<std::mutex> lock(_input_lock);
+	for (size_t i = 0; i < _editor.cursor(); ++i) {
+	    prefix.push_back(_editor.at(i));
+	};
+    }
+    if (prefix.find(' ') != std::string::npos) {
 	return;
-    } else if (_current_index >= _input_buffer.size()) {
-	_input_buffer.push_back(input);
+    };
+    const CommandRegistry::Snapshot commands = _commands.snapshot();
+    const CommandRegistry::Lookup lookup = commands.resolve(prefix);
+    std::string completion;
+    if (lookup._match == CommandRegistry::Match::EXACT ||
+	lookup._match == CommandRegistry::Match::UNIQUE_PREFIX) {
+	completion = lookup._name.substr(prefix.size()) + " ";
     } else {
-	auto it = _input_buffer.begin();
-	std::advance(it, _current_index);
-	_input_buffer.insert(it, input);
+	completion = commands.common_prefix(prefix).substr(prefix.size());
+    };
+    if (!completion.empty()) {
+	std::scoped_lock<std::mutex> lock(_input_lock);
+	_editor.insert(completion);
+	return;
+    };
+    if (lookup._match == CommandRegistry::Match::AMBIGUOUS) {
+	std::stringstream ss;
+	size_t i = 0;
+	commands.for_each(prefix, [&] (std::string_view name, auto const&) {
+	    ss << (i++ ? ", " : "") << name;
+	});
+	timestamped_message(ss.str());
     };
-    _current_index++;
+};
+
+void
+ConsoleWriter::ConsoleInterface::add_characters
+(std::string_view input) {
+    if (input.empty()) {
+	return;
+    };
+    std::string accepted;
+    accepted.reserve(input.size());
+    for (char const c : input) {
+	if (_acceptable_characters.find(c) != std::string::npos) {
+	    accepted.push_back(c);
+	};
+    };
+    std::scoped_lock<std::mutex> lock(_input_lock);
+    _editor.insert(accepted);
 };
 
 void ConsoleWriter::ConsoleInterface::move_index(int const direction) {
     switch (direction) {
     case KeyPress::LEFT: {
-	if (_current_index >= 1) {
-	    _current_index--;
-	};
+	_editor.move_left();
 	break;
     }
     case KeyPress::RIGHT: {
-	if (_current_index < _input_buffer.size()) {
-	    _current_index++;
-	};
+	_editor.move_right();
+	break;
+    }
+    case KeyPress::HOME: {
+	_editor.move_home();
+	break;
+    }
+    case KeyPress::END: {
+	_editor.move_end();
 	break;
     }
     default: {
@@ -279,88 +1204,90 @@ void ConsoleWriter::ConsoleInterface::move_index(int const direction) {
     };
 };
 
-void
-ConsoleWriter::ConsoleInterface::print_line
-(int line, Message output, bool const save_msg) {
-    if (line >= LINES - 3) {
-	adjust_lines();
-	line =  LINES - 3;
-    };
-    if (save_msg) {
-	save_message(std::move(output));
+void ConsoleWriter::ConsoleInterface::recall_command(int const direction) {
+    if (direction == KeyPress::UP) {
+	_editor.history_previous();
+    } else {
+	_editor.history_next();
     };
-    std::scoped_lock<std::mutex> lock(_print_lock);
-    move(line, 0);
-    clrtoeol();
-    output.send_message(line, 0);
 };
 
-void
-ConsoleWriter::ConsoleInterface::adjust_lines
-() {
-    const size_t bottom_row = static_cast<size_t>(LINES) - 3;
-    if (_sent_messages.size() >= bottom_row) {
-    	for (size_t i = 1; i <= bottom_row; ++i) {
-	    const auto index = _sent_messages.size() - i;
-    	    print_line(bottom_row - i, _sent_messages[index], false);
-    	};
+void ConsoleWriter::ConsoleInterface::scroll_view(int const key) noexcept {
+    const int64_t page = _page_rows.load();
+    switch (key) {
+    case KeyPress::SCROLL_UP: {
+	scroll_log(1);
+	break;
+    }
+    case KeyPress::SCROLL_DOWN: {
+	scroll_log(-1);
+	break;
+    }
+    case KeyPress::PAGE_UP: {
+	scroll_log(page);
+	break;
+    }
+    case KeyPress::PAGE_DOWN: {
+	scroll_log(-page);
+	break;
+    }
+    default: {
+	break;
+    };
     };
-    print_separator();
 };
 
 void
-ConsoleWriter::ConsoleInterface::print_input_buffer
-() {
-    std::scoped_lock<std::mutex> lock(_print_lock);
-    size_t i = 0;
-    move(LINES - 1, 0);
-    clrtoeol();
-    for (const auto &c : _input_buffer) {
-	if (i == _current_index) {
-	    attron(COLOR_PAIR(Message::HIGHLIGHT));
-	    mvaddch(LINES - 1, i, c);
-	    attroff(COLOR_PAIR(Message::HIGHLIGHT));
-	} else {
-	    mvaddch(LINES - 1, i, c);
+ConsoleWriter::ConsoleInterface::print_message
+(Message&& output, bool const save_msg) noexcept {
+    // a copy for every channel pane that shows it; "all" takes the
+    // original
+    for (size_t i = 1; i < _panes.size(); ++i) {
+	if (_panes[i].shows(output._channel)) {
+	    show_in_pane(i, Message(output), save_msg);
 	};
-	++i;
     };
-    if (_current_index == _input_buffer.size()) {
-	attron(COLOR_PAIR(Message::HIGHLIGHT));
-	    addch(' ');
-	    attroff(COLOR_PAIR(Message::HIGHLIGHT));
-    }
-    refresh();
+    show_in_pane(0, std::move(output), save_msg);
 };
 
-void ConsoleWriter::ConsoleInterface::print_separator() {
-    for (int i = 0; i < COLS; ++i) {
-	mvaddch(LINES - 2, i, '-');
+void
+ConsoleWriter::ConsoleInterface::show_in_pane
+(size_t const index, Message&& message, bool const save_msg) noexcept {
+    Pane& pane = _panes[index];
+    const size_t slot = slot_of(index);
+    if (pane._scroll_offset == 0) {
+	if (slot != NOT_SHOWN) {
+	    _renderer->append_line(slot, message);
+	};
+    } else if (save_msg && pane._scroll_offset +
+	       static_cast<size_t>(_renderer->log_rows(slot)) <
+	       pane._history.capacity()) {
+	// keep a scrolled-back view pinned to the lines it is showing
+	++pane._scroll_offset;
+    };
+    // only hand the message to the history once it has been drawn
+    if (save_msg) {
+	pane._history.push_back(std::move(message));
     };
 };
 
 void
-ConsoleWriter::ConsoleInterface::Message::send_message
-(int const row, int const column) const {
-    int index = column;
-    for (size_t i = 0; i < _colour_pairs.size() && i < _strs.size(); ++i) {
-	attron(COLOR_PAIR(_colour_pairs[i]));
-	mvaddstr(row, index, _strs[i].c_str());
-	attroff(COLOR_PAIR(_colour_pairs[i]));
-	index += _strs[i].size() + 1;
-    };
-    refresh();
+ConsoleWriter::ConsoleInterface::print_input_buffer
+() {
+    // the console thread redraws the input row as part of its next frame
+    _input_dirty = true;
+    wake();
 };
 
 void
-ConsoleWriter::ConsoleInterface::Message::add_chunk
-(std::string msg, int const colour) {
-    _strs.emplace_back(msg);
-    if (colour >= COLOURS_COUNT || colour < NORMAL) {
-	_colour_pairs.push_back(NORMAL);
-    } else {
-	_colour_pairs.push_back(colour);
-    };
+ConsoleWriter::ConsoleInterface::draw_input_buffer
+() noexcept {
+    std::scoped_lock<std::mutex> lock(_input_lock);
+    _editor.render(static_cast<size_t>(_renderer->columns()),
+		   [&] (size_t const column, char const c,
+			bool const is_cursor) {
+		       _renderer->draw_input_cell(column, c, is_cursor);
+		   });
 };
 
 void
@@ -372,17 +1299,99 @@ ConsoleWriter::ConsoleInterface::handle_command
 	command.substr(0, pos);
     const std::string arg = !args ? "" :
 	command.substr(pos + 1, command.size() - 1);
-    const auto it = _commands.find(cmd);
-    if (it == _commands.end()) {
+    // an empty line would prefix-match every command
+    if (cmd.empty()) {
+	return;
+    };
+    const CommandRegistry::Snapshot commands = _commands.snapshot();
+    const CommandRegistry::Lookup lookup = commands.resolve(cmd);
+    const std::shared_ptr<const Command> found = lookup._command;
+    if (lookup._match == CommandRegistry::Match::AMBIGUOUS) {
+	std::stringstream ss;
+	ss << "Command \"" << cmd << "\" is ambiguous:";
+	commands.for_each(cmd, [&] (std::string_view name, auto const&) {
+	    ss << ' ' << name;
+	});
+	error_message(ss.str());
+	return;
+    } else if (!found) {
 	std::stringstream ss;
 	ss << "Command \"" << cmd << "\" not found.";
 	error_message(ss.str());		      
-    } else {
-	const std::string result = it->second->_callback(arg);
+	return;
+    };
+    auto completion = [this, name = lookup._name]
+	(CommandExecutor::JobInfo const& job, std::string const& result) {
+	record_command_time(name, job._elapsed);
+	report_job(job, result);
+    };
+    const auto started = std::chrono::steady_clock::now();
+    if (found->_schema) {
+	// split and check once here, so a bad call never reaches a worker
+	Arguments arguments(arg);
+	const std::string error = found->_schema->bind(arguments);
+	if (!error.empty()) {
+	    std::stringstream ss;
+	    ss << lookup._name << ": " << error << ". Usage: "
+	       << lookup._name << " " << found->_schema->usage();
+	    error_message(ss.str());
+	} else if (found->_run_inline) {
+	    const std::string result = found->_typed_callback(arguments);
+	    record_command_time(lookup._name,
+				std::chrono::steady_clock::now() - started);
+	    handle_command_result(result);
+	} else {
+	    _executor->submit(std::string(command),
+			      [found, arguments = std::move(arguments)] () {
+				  return found->_typed_callback(arguments);
+			      },
+			      std::move(completion));
+	};
+    } else if (found->_run_inline) {
+	const std::string result = found->_callback(arg);
+	record_command_time(lookup._name,
+			    std::chrono::steady_clock::now() - started);
 	handle_command_result(result);
+    } else {
+	_executor->submit(std::string(command),
+			  [found, arg] () { return found->_callback(arg); },
+			  std::move(completion));
     };
 };
 
+void
+ConsoleWriter::ConsoleInterface::record_command_time
+(std::string const& command,
+ std::chrono::steady_clock::duration const elapsed) {
+    Histogram* histogram = nullptr;
+    {
+	std::scoped_lock<std::mutex> lock(_command_time_lock);
+	auto& slot = _command_time[command];
+	if (!slot) {
+	    slot = std::make_unique<Histogram>();
+	};
+	histogram = slot.get();
+    }
+    // never erased, so recording outside the lock is safe
+    histogram->record(static_cast<uint64_t>(
+	std::chrono::duration_cast<std::chrono::nanoseconds>
+	(elapsed).count()));
+};
+
+void
+ConsoleWriter::ConsoleInterface::report_job
+(CommandExecutor::JobInfo const& job, std::string const& result) {
+    std::stringstream ss;
+    ss << "[job " << job._id << (job._cancelled ? " cancelled after " : " ")
+       << format_duration(job._elapsed) << "]";
+    const std::string tag = ss.str();
+    Message msg(tag.size() + result.size() + job._command.size());
+    msg.stamp();
+    msg.add_chunk(tag, Message::INPUT);
+    msg.add_chunk(result.empty() ? job._command : result, Message::NORMAL);
+    add_message(std::move(msg));
+};
+
 void
 ConsoleWriter::ConsoleInterface::handle_command_result
 (std::string const& result) {
@@ -396,8 +1405,7 @@ void
 ConsoleWriter::ConsoleInterface::add_command
 (std::string&& command_string,
  std::shared_ptr<const Command> const& command) {
-    std::scoped_lock<std::mutex> lock(_commands_lock);
-    _commands[std::move(command_string)] = command;
+    _commands.add(command_string, command);
 };
 
 void
@@ -416,19 +1424,19 @@ ConsoleWriter::ConsoleInterface::add_default_commands
     auto commands = [&] (std::string const&) {
 	std::stringstream ss;
 	ss << "Commands: ";
-	std::scoped_lock<std::mutex> lock(_commands_lock);
+	const CommandRegistry::Snapshot snapshot = _commands.snapshot();
 	size_t i = 1;
-	for (auto const& cmd:_commands) {
-	    ss << cmd.first;
-	    if (i++ != _commands.size()) {
+	snapshot.for_each("", [&] (std::string_view name, auto const&) {
+	    ss << name;
+	    if (i++ != snapshot.size()) {
 		ss << ", ";
 	    };
-	}
+	});
 	return ss.str();
     };
     auto list_command = std::make_shared<ConsoleWriter::Command>
 	("List all commands",
-	 std::move(commands));
+	 std::move(commands), true);
     add_command("commands",
 		list_command);
 
@@ -439,30 +1447,335 @@ ConsoleWriter::ConsoleInterface::add_default_commands
 			       "and.Type \"commands\" for a list of commands.");
 	};
 	
-	auto cmd_it = _commands.find(cmd_arg);
-	if (cmd_it == _commands.end()) {
+	const CommandRegistry::Lookup lookup =
+	    _commands.snapshot().resolve(cmd_arg);
+	if (!lookup._command) {
 	    std::stringstream ss;
 	    ss << "Command \"" << cmd_arg <<
 		"\" not found, type \"commands\" to list all commands.";
 	    return ss.str();
 	} else {
 	    std::stringstream ss;
-	    ss << cmd_arg << ": " << cmd_it->second->_description;
+	    ss << lookup._name << ": " << lookup._command->_description;
+	    if (lookup._command->_schema) {
+		ss << " Usage: " << lookup._name << " "
+		   << lookup._command->_schema->usage();
+	    };
 	    return ss.str();
 	};
     };
     auto help_command = std::make_shared<Command>
 	("Type \"help <command>\" for help with that command.",
-	 std::move(help));
+	 std::move(help), true);
     add_command("help",
 		help_command);    
-};
 
-void
-ConsoleWriter::ConsoleInterface::save_message
-(Message && output) noexcept {
-    _sent_messages.emplace_back(std::move(output));
-    if (_sent_messages.size() > MAX_MSG_BUFFER) {
-	_sent_messages.erase(_sent_messages.begin());
+    // latency
+    auto latency = [&] (std::string const&) {
+	const LatencyReport report = render_latency();
+	std::stringstream ss;
+	ss << "Enqueue-to-screen latency over the last " << report._samples
+	   << " messages: p50 " << report._p50_us << " us, p99 "
+	   << report._p99_us << " us";
+	if (report._total_samples > report._samples) {
+	    ss << ". Since start-up (" << report._total_samples
+	       << "): mean " << report._mean_us << " us, std dev "
+	       << report._std_dev_us << " us, p99 ~"
+	       << report._total_p99_us << " us, max "
+	       << report._max_us << " us";
+	};
+	return ss.str();
+    };
+    auto latency_command = std::make_shared<Command>
+	("Show p50/p99 enqueue-to-screen latency of recent messages.",
+	 std::move(latency), true);
+    add_command("latency",
+		latency_command);
+
+    // stats
+    auto stats = [&] (Arguments const& args) {
+	if (args.flag("json")) {
+	    return metrics_json();
+	};
+	const MetricsReport report = metrics();
+	auto summary = [&] (Histogram::Snapshot const& snapshot,
+			    double const scale, char const* unit) {
+	    const Numerical::Statistics<double> s = snapshot.statistics();
+	    std::stringstream ss;
+	    ss << std::fixed << std::setprecision(1) << "mean "
+	       << s._mean / scale << unit << ", p50 "
+	       << s._median / scale << unit << ", p99 "
+	       << snapshot.quantile(0.99) / scale << unit << ", max "
+	       << s._max / scale << unit;
+	    return ss.str();
+	};
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(1) << "Up "
+	   << report._uptime_s << " s. Enqueued "
+	   << report._enqueued << " (" << report._enqueue_rate
+	   << "/s), rendered " << report._rendered << " ("
+	   << report._render_rate << "/s), " << report._queue_depth
+	   << " queued, dropped " << report._dropped << ", collapsed "
+	   << report._collapsed << ", rate limited "
+	   << report._rate_limited << ". Latency: "
+	   << summary(report._latency, 1000.0, " us") << ". "
+	   << report._frames << " frames: "
+	   << summary(report._frame_time, 1000.0, " us") << "; "
+	   << summary(report._frame_batch, 1.0, "") << " messages each.";
+	for (auto const& [name, snapshot] : report._command_time) {
+	    ss << " " << name << " x" << snapshot._count << ": "
+	       << summary(snapshot, 1000.0, " us") << ".";
+	};
+	return ss.str();
+    };
+    auto stats_command = std::make_shared<Command>
+	("Show console throughput, latency, frame and command timings; "
+	 "--json for a machine-readable snapshot.",
+	 ArgumentSchema().flag("json"),
+	 std::move(stats), true);
+    add_command("stats",
+		stats_command);
+
+    // jobs
+    auto jobs = [&] (Arguments const&) {
+	auto running = _executor->jobs();
+	if (running.empty()) {
+	    return std::string("No commands running.");
+	};
+	std::sort(running.begin(), running.end(),
+		  [] (auto const& a, auto const& b) { return a._id < b._id; });
+	std::stringstream ss;
+	ss << "Jobs: ";
+	for (size_t i = 0; i < running.size(); ++i) {
+	    auto const& job = running[i];
+	    ss << job._id << " \"" << job._command << "\" ("
+	       << (job._cancelled ? "cancelling " :
+		   job._running ? "running " : "queued ")
+	       << format_duration(job._elapsed) << ")";
+	    if (i + 1 != running.size()) {
+		ss << ", ";
+	    };
+	};
+	return ss.str();
+    };
+    auto jobs_command = std::make_shared<Command>
+	("List running and queued commands.",
+	 ArgumentSchema(),
+	 std::move(jobs), true);
+    add_command("jobs",
+		jobs_command);
+
+    // cancel
+    auto cancel = [&] (Arguments const& args) {
+	const int64_t job = *args.integer(0);
+	if (job < 0) {
+	    return std::string("Usage: cancel <job id>");
+	};
+	const uint64_t id = static_cast<uint64_t>(job);
+	std::stringstream ss;
+	if (_executor->cancel(id)) {
+	    ss << "Cancellation requested for job " << id << ".";
+	} else {
+	    ss << "No job " << id << ", type \"jobs\" to list jobs.";
+	};
+	return ss.str();
+    };
+    auto cancel_command = std::make_shared<Command>
+	("Type \"cancel <job id>\" to ask a running command to stop.",
+	 ArgumentSchema().required("job", ArgumentType::INTEGER),
+	 std::move(cancel), true);
+    add_command("cancel",
+		cancel_command);
+
+    // queue
+    auto queue = [&] (Arguments const& args) {
+	static const std::pair<std::string_view, OverflowPolicy> policies[] {
+	    { "block", OverflowPolicy::BLOCK },
+	    { "drop-newest", OverflowPolicy::DROP_NEWEST },
+	    { "drop-oldest", OverflowPolicy::DROP_OLDEST },
+	    { "sample", OverflowPolicy::SAMPLE }
+	};
+	if (!args.empty()) {
+	    const auto it = std::find_if
+		(std::begin(policies), std::end(policies),
+		 [&] (auto const& p) { return p.first == args[0]; });
+	    if (it == std::end(policies)) {
+		return std::string("Policies: block, drop-newest, "
+				   "drop-oldest, sample");
+	    };
+	    set_overflow_policy(it->second, static_cast<size_t>
+				(std::max<int64_t>(args.integer(1)
+						   .value_or(10), 1)));
+	};
+	const QueueReport report = queue_report();
+	const auto name = std::find_if
+	    (std::begin(policies), std::end(policies),
+	     [&] (auto const& p) { return p.second == report._policy; });
+	std::stringstream ss;
+	if (report._thread_buffers > 0) {
+	    ss << report._thread_buffers << " thread buffers, ";
+	} else {
+	    ss << "Queue " << report._queued << "/" << report._capacity
+	       << ", ";
+	};
+	ss << report._errors_queued << " errors queued, policy "
+	   << name->first;
+	if (report._policy == OverflowPolicy::SAMPLE) {
+	    ss << " 1 in " << report._sample_every;
+	};
+	ss << ". Blocked " << report._blocked << ", dropped newest "
+	   << report._dropped_newest << ", dropped oldest "
+	   << report._dropped_oldest << ", sampled out "
+	   << report._sampled_out << ".";
+	return ss.str();
+    };
+    auto queue_command = std::make_shared<Command>
+	("Show message queue overflow counters, or set the overflow "
+	 "policy.",
+	 ArgumentSchema().optional("policy", ArgumentType::STRING)
+	 .optional("sample_every", ArgumentType::INTEGER),
+	 std::move(queue), true);
+    add_command("queue",
+		queue_command);
+
+    // filter
+    auto filter = [&] (Arguments const& args) {
+	MessageFilter::Settings settings = message_filter();
+	if (const auto window = args.option_duration("window")) {
+	    settings._duplicate_window =
+		std::chrono::duration_cast<std::chrono::milliseconds>(*window);
+	};
+	if (const auto rate = args.option_number("rate")) {
+	    // written so NaN fails too
+	    if (!(*rate >= 0.0) || !std::isfinite(*rate)) {
+		return std::string("--rate must be 0 (no limit) or more.");
+	    };
+	    settings._rate_per_second = *rate;
+	};
+	if (const auto burst = args.option_number("burst")) {
+	    // below one token a source could never send anything
+	    if (!(*burst >= 1.0) || !std::isfinite(*burst)) {
+		return std::string("--burst must be at least 1.");
+	    };
+	    settings._burst = *burst;
+	};
+	set_message_filter(settings);
+	std::stringstream ss;
+	ss << "Repeats within " << settings._duplicate_window.count()
+	   << " ms collapse";
+	if (settings._rate_per_second > 0.0) {
+	    ss << ", each source limited to " << settings._rate_per_second
+	       << "/s (burst " << settings._burst << ")";
+	} else {
+	    ss << ", no rate limit";
+	};
+	ss << ". Collapsed " << _filter_collapsed.load()
+	   << ", rate limited " << _filter_rate_limited.load() << ".";
+	return ss.str();
+    };
+    auto filter_command = std::make_shared<Command>
+	("Show or set repeat collapsing and per-source rate limits.",
+	 ArgumentSchema().option("window", ArgumentType::DURATION)
+	 .option("rate", ArgumentType::NUMBER)
+	 .option("burst", ArgumentType::NUMBER),
+	 std::move(filter), true);
+    add_command("filter",
+		filter_command);
+
+    // log
+    auto log = [&] (Arguments const& args) {
+	if (!args.empty()) {
+	    const std::string name(args[0]);
+	    const auto level = parse_log_level(name);
+	    if (!level && name != "default") {
+		return std::string("Levels: trace, debug, info, warning, "
+				   "error, off, or default to clear a "
+				   "channel's level");
+	    };
+	    if (args.size() == 1) {
+		if (level) {
+		    set_log_level(*level);
+		};
+	    };
+	    for (size_t i = 1; i < args.size(); ++i) {
+		const Channel named = channel(std::string(args[i]));
+		if (level) {
+		    set_log_level(named, *level);
+		} else {
+		    clear_log_level(named);
+		};
+	    };
+	};
+	std::stringstream ss;
+	ss << "Log level " << log_level_name(log_level());
+	for (auto const& [named, level] : channel_log_levels()) {
+	    ss << ", " << channel_name(named) << " "
+	       << log_level_name(level);
+	};
+	ss << "; compiled from " << log_level_name(COMPILED_LOG_LEVEL)
+	   << ".";
+	return ss.str();
+    };
+    auto log_command = std::make_shared<Command>
+	("Show or set the log level, for every channel or for the "
+	 "channels named.",
+	 ArgumentSchema().optional("level", ArgumentType::STRING)
+	 .variadic("channels", ArgumentType::STRING),
+	 std::move(log), true);
+    add_command("log",
+		log_command);
+
+    // pane
+    auto pane = [&] (Arguments const& args) {
+	const std::string action(args.empty() ? "" : args[0]);
+	const std::string name(args.size() > 1 ? args[1] : "");
+	std::vector<Channel> channels;
+	for (size_t i = 2; i < args.size(); ++i) {
+	    channels.push_back(channel(std::string(args[i])));
+	};
+	bool done = true;
+	if (action == "add" && !name.empty()) {
+	    done = add_pane(name, std::move(channels));
+	} else if (action == "filter" && !name.empty()) {
+	    done = set_pane_channels(name, std::move(channels));
+	} else if (action == "remove" && !name.empty()) {
+	    done = remove_pane(name);
+	} else if (action == "focus" && !name.empty()) {
+	    done = focus_pane(name);
+	} else if (action == "split" || action == "single") {
+	    set_split_panes(action == "split");
+	} else if (!action.empty()) {
+	    return std::string("Usage: pane [add|filter <name> [channel ...]"
+			       " | remove|focus <name> | split | single]");
+	};
+	if (!done) {
+	    return "Cannot " + action + " pane \"" + name + "\".";
+	};
+	const PaneReport report = panes();
+	std::stringstream ss;
+	ss << "Panes" << (report._split ? " (split): " : ": ");
+	for (size_t i = 0; i < report._panes.size(); ++i) {
+	    auto const& settings = report._panes[i];
+	    ss << (i == report._focus ? "*" : "") << settings._name << " [";
+	    if (settings._channels.empty()) {
+		ss << "every channel";
+	    };
+	    for (size_t j = 0; j < settings._channels.size(); ++j) {
+		ss << (j != 0 ? " " : "")
+		   << channel_name(settings._channels[j]);
+	    };
+	    ss << "]" << (i + 1 != report._panes.size() ? ", " : ".");
+	};
+	return ss.str();
     };
+    auto pane_command = std::make_shared<Command>
+	("List log panes, add or remove a pane showing some channels, "
+	 "change its channels, focus it, or split the screen between "
+	 "them.",
+	 ArgumentSchema().optional("action", ArgumentType::STRING)
+	 .optional("pane", ArgumentType::STRING)
+	 .variadic("channels", ArgumentType::STRING),
+	 std::move(pane), true);
+    add_command("pane",
+		pane_command);
 };
@@ -1,44 +1,103 @@
 #ifndef CLASS_CONSOLE
 #define CLASS_CONSOLE
 
-#define DEBUG 0
-
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
-#include <queue>
 #include <string>
 #include <mutex>
 #include <memory>
-#include <list>
 #include <functional>
-#include <unordered_map>
+#include <map>
+#include <sstream>
 
+#include "command.hpp"
+#include "command_executor.hpp"
+#include "channel.hpp"
+#include "command_registry.hpp"
+#include "ansi_renderer.hpp"
+#include "line_editor.hpp"
+#include "log_level.hpp"
+#include "log_sink.hpp"
+#include "memory_renderer.hpp"
+#include "message.hpp"
+#include "message_filter.hpp"
+#include "metrics.hpp"
+#include "mpsc_queue.hpp"
+#include "null_renderer.hpp"
+#include "numerical.hpp"
+#include "producer_rings.hpp"
+#include "renderer.hpp"
+#include "ring_buffer.hpp"
+#include "status_board.hpp"
 #include "threaded_process.hpp"
 
+// CONSOLE_LOG(LogLevel::TRACE, "x = ", expensive(x)) logs like
+// log_message, but the arguments sit in a discarded if constexpr branch
+// below COMPILED_LOG_LEVEL, so they are never evaluated, and behind the
+// runtime check above it. CONSOLE_LOG_TO names the channel
+#define CONSOLE_LOG_TO(LEVEL, CHANNEL, ...)\
+    do {\
+	if constexpr ((LEVEL) >= ::ConsoleWriter::COMPILED_LOG_LEVEL &&\
+		      (LEVEL) != ::ConsoleWriter::LogLevel::OFF) {\
+	    if (::ConsoleWriter::might_log(LEVEL)) {\
+		::ConsoleWriter::log_message_to<LEVEL>((CHANNEL),\
+						       __VA_ARGS__);\
+	    };\
+	};\
+    } while (false)
+#define CONSOLE_LOG(LEVEL, ...)\
+    CONSOLE_LOG_TO(LEVEL, ::ConsoleWriter::thread_channel(), __VA_ARGS__)
+
 namespace ConsoleWriter {
-    namespace ESC {
-	static const std::string red = "\u001b[38;5;196m";
-	static const std::string gre = "\u001b[38;5;82m";
-	static const std::string yel = "\u001b[38;5;226m";
-	static const std::string blu = "\u001b[38;5;21m";
-	static const std::string mag = "\u001b[38;5;165m";
-	static const std::string cya = "\u001b[38;5;51m";
-	static const std::string whi = "\u001b[38;5;225m";
-	static const std::string reset = "\033[0m";
+    void timestamped_message(const std::string &message) noexcept;
+    void error_message(const std::string &message) noexcept;
+    // tagged for the panes that show channel
+    void timestamped_message(Channel const channel,
+			     const std::string &message) noexcept;
+    void error_message(Channel const channel,
+		       const std::string &message) noexcept;
+
+    // tagged with the level, ERROR through the error queue
+    void log_message(LogLevel const level, Channel const channel,
+		     const std::string &message) noexcept;
+
+    // Leveled messages, written log_message<LogLevel::TRACE>("x = ", x).
+    // The parts are only streamed into a message once the level passes
+    // COMPILED_LOG_LEVEL and the runtime level, but as with any call they
+    // are evaluated first; CONSOLE_LOG skips evaluating them too
+    template <LogLevel LEVEL, typename... Parts>
+    void
+    log_message_to
+    (Channel const channel, Parts const&... parts) noexcept {
+	if constexpr (LEVEL >= COMPILED_LOG_LEVEL &&
+		      LEVEL != LogLevel::OFF) {
+	    if (!log_enabled(LEVEL, channel)) {
+		return;
+	    };
+	    try {
+		std::ostringstream ss;
+		(ss << ... << parts);
+		log_message(LEVEL, channel, ss.str());
+	    } catch ( ... ) {
+	    };
+	};
     };
 
-    struct Command {
-	Command(std::string&& description,
-		std::function<std::string(std::string const&)>&& callback) {
-	    _description = std::move(description);
-	    _callback = std::move(callback);
+    // on the thread's channel
+    template <LogLevel LEVEL, typename... Parts>
+    void
+    log_message
+    (Parts const&... parts) noexcept {
+	if constexpr (LEVEL >= COMPILED_LOG_LEVEL &&
+		      LEVEL != LogLevel::OFF) {
+	    if (might_log(LEVEL)) {
+		log_message_to<LEVEL>(thread_channel(), parts...);
+	    };
 	};
-	std::string _description;
-	std::function<std::string(std::string const&)> _callback;
     };
-    
-    void timestamped_message(const std::string &message) noexcept;
-    void error_message(const std::string &message) noexcept;
     std::string in_colour(const std::string &message,
 			  const std::string &colour) noexcept;
     std::string timestamp(const bool padded) noexcept;
@@ -52,30 +111,117 @@ namespace ConsoleWriter {
     void shutdown();
     void end_console_loop();
 	
+    // What add_message does when the message queue is full
+    enum class OverflowPolicy {
+	// wait for the console to make room
+	BLOCK,
+	// drop the message being added
+	DROP_NEWEST,
+	// evict the oldest queued message to make room
+	DROP_OLDEST,
+	// once the queue is past its high-water mark keep one message in
+	// sample_every and drop the rest
+	SAMPLE
+    };
+
+    struct ConsoleOptions {
+	// each producing thread writes into its own ring, merged by the
+	// console in enqueue-time order; otherwise every thread shares
+	// one queue of _queue_capacity. Rings cannot evict from the
+	// producer side, so drop-oldest behaves as drop-newest for them
+	bool _thread_buffers { false };
+	size_t _thread_buffer_capacity { 256 };
+	size_t _queue_capacity { 8192 };
+	OverflowPolicy _overflow_policy { OverflowPolicy::BLOCK };
+	size_t _sample_every { 10 };
+	// error_message() has its own queue, so errors are never dropped
+	// or stuck behind a backlog of normal messages
+	size_t _error_lane_capacity { 1024 };
+	MessageFilter::Settings _filter;
+	// COOPERATIVE draws frames from a task on ProcessExecutor::shared()
+	// rather than the console's own thread; keystrokes are still read
+	// on a thread of their own. Cooperative producers on the same
+	// executor should not use BLOCK, which waits for the console
+	ExecutionMode _execution_mode { ExecutionMode::DEDICATED_THREAD };
+    };
+
     class ConsoleInterface final :
 	public ThreadedProcess {
     public:
-	class Message {
-	public:
-	    enum Colours {
-		NORMAL,
-		HIGHLIGHT,
-		ERROR,
-		TIMESTAMP,
-		INPUT,
-		COLOURS_COUNT
-	    };
+	using Message = ConsoleWriter::Message;
+
+	struct LatencyReport {
+	    // exact, over the last LATENCY_SAMPLES messages
+	    double _p50_us;
+	    double _p99_us;
+	    size_t _samples;
+	    // from the latency histogram, over every message since start-up
+	    uint64_t _total_samples;
+	    double _mean_us;
+	    double _std_dev_us;
+	    double _max_us;
+	    double _total_p99_us;
+	};
+
+	struct QueueReport {
+	    size_t _capacity;
+	    size_t _queued;
+	    size_t _errors_queued;
+	    // producer threads with a live ring, 0 with a shared queue
+	    size_t _thread_buffers;
+	    OverflowPolicy _policy;
+	    size_t _sample_every;
+	    size_t _blocked;
+	    size_t _dropped_newest;
+	    size_t _dropped_oldest;
+	    size_t _sampled_out;
+	};
+
+	struct MetricsReport {
+	    double _uptime_s;
+	    // messages handed to the console, including any the overflow
+	    // policy then dropped, and messages drawn
+	    uint64_t _enqueued;
+	    uint64_t _rendered;
+	    uint64_t _frames;
+	    // per second, over the last one to two seconds
+	    double _enqueue_rate;
+	    double _render_rate;
+	    // shared queue and error lane right now
+	    size_t _queue_depth;
+	    size_t _dropped;
+	    size_t _collapsed;
+	    size_t _rate_limited;
+	    // nanoseconds, except _frame_batch which counts the messages
+	    // each frame drained
+	    Histogram::Snapshot _latency;
+	    Histogram::Snapshot _frame_time;
+	    Histogram::Snapshot _frame_batch;
+	    std::map<std::string, Histogram::Snapshot> _command_time;
+	};
 
-	    Message() = default;
-	    void send_message(int const row, int const column) const;
-	    void add_chunk(std::string msg, int const colour);
-	    std::vector<int> _colour_pairs;
-	    std::vector<std::string> _strs;
+	struct PaneSettings {
+	    std::string _name;
+	    // empty shows every channel
+	    std::vector<Channel> _channels;
+	};
+
+	struct PaneReport {
+	    // the first is "all"
+	    std::vector<PaneSettings> _panes;
+	    size_t _focus;
+	    bool _split;
 	};
     public:
-	static std::shared_ptr<ConsoleWriter::ConsoleInterface> create();
+	// a null renderer picks the default backend, see
+	// default_render_backend()
+	static std::shared_ptr<ConsoleWriter::ConsoleInterface>
+	create(std::unique_ptr<Renderer> renderer = nullptr,
+	       ConsoleOptions const& options = ConsoleOptions());
 
-	ConsoleInterface();
+	explicit ConsoleInterface(std::unique_ptr<Renderer> renderer = nullptr,
+				  ConsoleOptions const& options =
+				  ConsoleOptions());
 	~ConsoleInterface();
 
 	// PURE VIRTUAL FUNCTIONS
@@ -84,22 +230,97 @@ namespace ConsoleWriter {
 	// END OF PURE VIRTUAL FUNCTIONS
 
 	
-	void add_message(Message const& message);
+	// false if the overflow policy dropped the message
+	bool add_message(Message&& message);
+	// through the error lane; waits rather than drop
+	void add_error_message(Message&& message);
 
 	void run_console();
 
+	// 0 disables the cap and renders as soon as messages arrive
+	void set_max_frame_rate(unsigned int const frames_per_second) noexcept;
+	LatencyReport render_latency() const;
+	// applied by the console thread on its next frame; keeps the
+	// newest lines when shrinking. Channel panes keep at most
+	// CHANNEL_SCROLLBACK_LINES
+	void set_scrollback_capacity(size_t const lines) noexcept;
+	// every message drawn from now on is also handed to the sink;
+	// nullptr stops logging
+	void set_log_sink(std::shared_ptr<LogSink> sink);
+
+	void set_overflow_policy(OverflowPolicy const policy,
+				 size_t const sample_every = 10) noexcept;
+	QueueReport queue_report() const noexcept;
+	// safe from any thread; cheap enough to poll every second
+	MetricsReport metrics() const;
+	// the same as one JSON object, for monitoring
+	std::string metrics_json() const;
+
+	// applied by the console thread on its next frame
+	void set_message_filter(MessageFilter::Settings const& settings);
+	MessageFilter::Settings message_filter() const;
+
+	// progress bars, counters and rates pinned above the separator;
+	// update them from any thread instead of printing progress lines
+	StatusBoard& status() noexcept { return *_status_board; }
+
+	// Panes split the log by channel, each with its own scrollback;
+	// paging keys act on the focused one. The first pane, "all",
+	// shows every channel and cannot be changed. Applied by the
+	// console thread on its next frame.
+	// false if the pane already exists
+	bool add_pane(std::string name, std::vector<Channel> channels);
+	// false if there is no such pane, or it is "all"
+	bool set_pane_channels(std::string const& name,
+			       std::vector<Channel> channels);
+	bool remove_pane(std::string const& name);
+	bool focus_pane(std::string const& name);
+	// moves the focus by step panes, wrapping round
+	void cycle_pane_focus(int const step);
+	// every pane stacked on screen, or only the focused one
+	void set_split_panes(bool const split);
+	PaneReport panes() const;
+
 	void add_command(std::string&& command_string,
 			 std::shared_ptr<const Command> const& command);
 	void add_command(std::vector<std::string>&& command_strings,
 			 std::shared_ptr<const Command> const& command);
     private:
 	static const std::string _acceptable_characters;
-	void print_line(int line, Message output,
-			const bool save_msg = true);
-	void send_next_message() noexcept;
-	std::string current_buffer_string() noexcept;
+	void print_message(Message&& output,
+			   const bool save_msg = true) noexcept;
+	void send_pending_messages() noexcept;
 	void check_for_input() noexcept;
 	void send_shutdown_message() noexcept;
+	void on_shutdown() noexcept override;
+	bool run_once() override;
+
+	bool push_to_thread_buffer(Message&& message,
+				   OverflowPolicy const policy) noexcept;
+	// a BLOCK producer sleeps here until pushed() succeeds
+	template <typename Push>
+	void park_producer(Push&& pushed) noexcept;
+	void wake() noexcept;
+	void wait_for_messages();
+	void render_frame() noexcept;
+	void record_frame_latencies() noexcept;
+	void record_command_time(std::string const& command,
+				 std::chrono::steady_clock::duration const
+				 elapsed);
+	void scroll_log(int64_t const lines) noexcept;
+	void apply_view_changes() noexcept;
+	void draw_status() noexcept;
+	void draw_status_widgets() noexcept;
+	void apply_pane_changes();
+	void layout_panes() noexcept;
+	void redraw_pane(size_t const pane) noexcept;
+	// where a pane is on screen, or NOT_SHOWN
+	size_t slot_of(size_t const pane) const noexcept;
+	void show_in_pane(size_t const pane, Message&& message,
+			  bool const save_msg) noexcept;
+	// when the filter or a status row next needs a frame
+	std::chrono::steady_clock::time_point next_deadline() const noexcept;
+	size_t dropped_messages() const noexcept;
 
 	void run_user_input();
 
@@ -108,41 +329,166 @@ namespace ConsoleWriter {
 	    UP = 259,
 	    LEFT = 260,
 	    RIGHT = 261,
+	    HOME = 262,
 	    BACKSPACE = 263,
+	    DELETE = 330,
+	    SCROLL_DOWN = 336,
+	    SCROLL_UP = 337,
+	    PAGE_DOWN = 338,
+	    PAGE_UP = 339,
+	    END = 360,
 	    ENTER = 10,
+	    TAB = 9,
 	    ESCAPE = 27,
+	    DEL = 127,
+	    // ctrl-n, ctrl-p and ctrl-t
+	    NEXT_PANE = 14,
+	    PREVIOUS_PANE = 16,
+	    SPLIT_PANES = 20,
 	};
+	void handle_keys(std::vector<int> const& keys);
 	void handle_input(int const input);
-	void remove_character();
+	void remove_character(int const key);
 	void move_index(int const direction);
+	void recall_command(int const direction);
+	void scroll_view(int const key) noexcept;
 	void execute_message();
-	void add_character(char const input);
+	void complete_command();
+	void add_characters(std::string_view input);
 	void print_input_buffer();
-	void print_separator();
-	void adjust_lines();
+	void draw_input_buffer() noexcept;
 	void handle_command(std::string const& command);
 	void handle_command_result(std::string const& result);
+	void report_job(CommandExecutor::JobInfo const& job,
+			std::string const& result);
 
 	void add_default_commands();
-	void save_message(Message && msg) noexcept;
     private:
-	static constexpr size_t MAX_MSG_BUFFER { 100 };
-	
-	std::queue<Message> _message_queue;
-	std::mutex _msg_lock;
+	static constexpr size_t DEFAULT_SCROLLBACK_LINES { 100000 };
+	// each channel pane holds a copy of its lines, so it keeps fewer
+	static constexpr size_t CHANNEL_SCROLLBACK_LINES { 10000 };
+	static constexpr unsigned int DEFAULT_FRAME_RATE { 60 };
+	static constexpr size_t LATENCY_SAMPLES { 4096 };
+	static constexpr int INPUT_POLL_MS { 100 };
+	static constexpr size_t COMMAND_WORKERS { 4 };
+
+	MpscQueue<Message> _message_queue;
+	MpscQueue<Message> _error_queue;
+	std::unique_ptr<ProducerRings> _producer_rings;
+	std::atomic<size_t> _thread_buffer_count { 0 };
+
+	// overflow handling; the counters only move when the queue is full
+	std::atomic<OverflowPolicy> _overflow_policy;
+	std::atomic<size_t> _sample_every;
+	std::atomic<size_t> _overflow_count { 0 };
+	std::atomic<size_t> _blocked { 0 };
+	// producers parked by BLOCK, woken once a frame has made room
+	std::mutex _room_lock;
+	std::condition_variable _room;
+	std::atomic<size_t> _parked_producers { 0 };
+	std::atomic<size_t> _dropped_newest { 0 };
+	std::atomic<size_t> _dropped_oldest { 0 };
+	std::atomic<size_t> _sampled_out { 0 };
+
+	// repeat collapsing and rate limits, run by the console thread
+	MessageFilter _filter;
+	mutable std::mutex _filter_lock;
+	MessageFilter::Settings _filter_settings;
+	std::atomic<bool> _filter_dirty { false };
+	std::atomic<size_t> _filter_collapsed { 0 };
+	std::atomic<size_t> _filter_rate_limited { 0 };
+
+	// render loop wakeup
+	std::mutex _wake_lock;
+	std::condition_variable _wake_cv;
+	std::atomic<bool> _sleeping { false };
+	std::atomic<int64_t> _min_frame_interval_ns { 0 };
+	ExecutionMode const _execution_mode;
+	std::chrono::steady_clock::time_point _last_frame;
+
+	// enqueue-to-screen latency of the most recent messages
+	mutable std::mutex _latency_lock;
+	std::vector<double> _latency_samples;
+	size_t _latency_index { 0 };
+	std::vector<std::chrono::steady_clock::time_point> _frame_enqueue_times;
+
+	// lock-free, written on the hot paths and read by metrics()
+	std::chrono::steady_clock::time_point const _started;
+	Counter _enqueued;
+	Counter _rendered;
+	Counter _frames;
+	Histogram _latency_histogram;
+	Histogram _frame_time;
+	Histogram _frame_batch;
+	// one histogram per command name, created on first use
+	mutable std::mutex _command_time_lock;
+	std::map<std::string, std::unique_ptr<Histogram>> _command_time;
+	// the counters a second or so ago, for the rates
+	struct RateSample {
+	    std::chrono::steady_clock::time_point _time;
+	    uint64_t _enqueued;
+	    uint64_t _rendered;
+	};
+	mutable std::mutex _rate_lock;
+	mutable RateSample _rate_previous;
+	mutable RateSample _rate_current;
+	// the renderer is only ever entered with this held
 	std::mutex _print_lock;
-	std::mutex _commands_lock;
+	std::unique_ptr<Renderer> _renderer;
+	std::shared_ptr<LogSink> _log_sink;
 
 	// user entry
 	std::unique_ptr<std::thread> _user_entry_thread;
-	std::list<char> _input_buffer;
-	std::vector<Message> _sent_messages;
-	bool _terminal_running;
-	size_t _current_index;
+	std::mutex _input_lock;
+	std::atomic<bool> _input_dirty { false };
+	LineEditor _editor;
+
+	// scrollback view, requested by the input thread and applied by
+	// the console thread so paging never blocks ingestion
+	std::atomic<bool> _view_dirty { false };
+	std::atomic<int64_t> _scroll_request { 0 };
+	std::atomic<bool> _scroll_to_bottom { false };
+	std::atomic<size_t> _scrollback_request { 0 };
+	size_t _drawn_scroll_offset { 0 };
+	size_t _drawn_focus { 0 };
+	size_t _drawn_dropped { 0 };
+	// a page of the focused pane, for the input thread's paging keys
+	std::atomic<int> _page_rows { 1 };
+
+	// panes, requested from any thread
+	mutable std::mutex _pane_lock;
+	std::vector<PaneSettings> _pane_settings;
+	size_t _pane_focus { 0 };
+	bool _split_panes { false };
+	std::atomic<bool> _panes_dirty { false };
+	// and as the console thread has them
+	struct Pane {
+	    Pane(PaneSettings&& settings, size_t const capacity)
+		: _settings(std::move(settings))
+		, _history(capacity) {}
+
+	    bool shows(Channel const channel) const noexcept;
+
+	    PaneSettings _settings;
+	    RingBuffer<Message> _history;
+	    size_t _scroll_offset { 0 };
+	};
+	static constexpr size_t NOT_SHOWN { SIZE_MAX };
+	std::vector<Pane> _panes;
+	size_t _focus { 0 };
+	bool _split { false };
+	// the panes on screen, in order
+	size_t _first_shown { 0 };
+	size_t _shown { 1 };
+
+	// pinned status rows, drawn by the console thread
+	std::shared_ptr<StatusBoard> _status_board;
+	size_t _status_rows { 0 };
+	std::atomic<bool> _terminal_running;
 
 	// commands
-	std::unordered_map<std::string,
-			   std::shared_ptr<const Command>> _commands;
+	CommandRegistry _commands;
+	std::unique_ptr<CommandExecutor> _executor;
     };
 };
 
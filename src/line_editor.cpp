@@ -0,0 +1,166 @@
+#include "line_editor.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr size_t INITIAL_GAP { 128 };
+};
+
+ConsoleWriter::LineEditor::LineEditor
+()
+    : _buffer(INITIAL_GAP)
+    , _gap_end(INITIAL_GAP) {
+};
+
+void
+ConsoleWriter::LineEditor::insert
+(std::string_view text) {
+    if (text.empty()) {
+	return;
+    };
+    reserve_gap(text.size());
+    std::memcpy(_buffer.data() + _gap_start, text.data(), text.size());
+    _gap_start += text.size();
+};
+
+void
+ConsoleWriter::LineEditor::erase_before
+() noexcept {
+    if (_gap_start > 0) {
+	--_gap_start;
+    };
+};
+
+void
+ConsoleWriter::LineEditor::erase_after
+() noexcept {
+    if (_gap_end < _buffer.size()) {
+	++_gap_end;
+    };
+};
+
+void
+ConsoleWriter::LineEditor::move_left
+() noexcept {
+    if (_gap_start > 0) {
+	move_gap(_gap_start - 1);
+    };
+};
+
+void
+ConsoleWriter::LineEditor::move_right
+() noexcept {
+    if (_gap_start < size()) {
+	move_gap(_gap_start + 1);
+    };
+};
+
+void
+ConsoleWriter::LineEditor::move_home
+() noexcept {
+    move_gap(0);
+};
+
+void
+ConsoleWriter::LineEditor::move_end
+() noexcept {
+    move_gap(size());
+};
+
+void
+ConsoleWriter::LineEditor::history_previous
+() {
+    if (_history_index == 0) {
+	return;
+    };
+    if (_history_index == _history.size()) {
+	_draft = text();
+    };
+    --_history_index;
+    replace(_history[_history_index]);
+};
+
+void
+ConsoleWriter::LineEditor::history_next
+() {
+    if (_history_index >= _history.size()) {
+	return;
+    };
+    ++_history_index;
+    replace(_history_index == _history.size() ? _draft :
+	    _history[_history_index]);
+};
+
+std::string
+ConsoleWriter::LineEditor::commit
+() {
+    std::string line = text();
+    if (!line.empty() && (_history.empty() || _history.back() != line)) {
+	_history.push_back(line);
+	if (_history.size() > HISTORY_SIZE) {
+	    _history.pop_front();
+	};
+    };
+    _history_index = _history.size();
+    _draft.clear();
+    replace(std::string_view());
+    return line;
+};
+
+std::string
+ConsoleWriter::LineEditor::text
+() const {
+    std::string line;
+    line.reserve(size());
+    line.append(_buffer.data(), _gap_start);
+    line.append(_buffer.data() + _gap_end, _buffer.size() - _gap_end);
+    return line;
+};
+
+void
+ConsoleWriter::LineEditor::move_gap
+(size_t const position) noexcept {
+    if (position < _gap_start) {
+	const size_t count = _gap_start - position;
+	std::memmove(_buffer.data() + _gap_end - count,
+		     _buffer.data() + position, count);
+	_gap_start -= count;
+	_gap_end -= count;
+    } else if (position > _gap_start) {
+	const size_t count = position - _gap_start;
+	std::memmove(_buffer.data() + _gap_start,
+		     _buffer.data() + _gap_end, count);
+	_gap_start += count;
+	_gap_end += count;
+    };
+};
+
+void
+ConsoleWriter::LineEditor::reserve_gap
+(size_t const length) {
+    const size_t gap = _gap_end - _gap_start;
+    if (gap >= length) {
+	return;
+    };
+    // double the buffer so a long paste grows it only a few times
+    const size_t tail = _buffer.size() - _gap_end;
+    const size_t new_size = std::max(_buffer.size() * 2,
+				     _buffer.size() - gap + length +
+				     INITIAL_GAP);
+    std::vector<char> buffer(new_size);
+    std::memcpy(buffer.data(), _buffer.data(), _gap_start);
+    std::memcpy(buffer.data() + new_size - tail,
+		_buffer.data() + _gap_end, tail);
+    _gap_end = new_size - tail;
+    _buffer = std::move(buffer);
+};
+
+void
+ConsoleWriter::LineEditor::replace
+(std::string_view text) {
+    _gap_start = 0;
+    _gap_end = _buffer.size();
+    _scroll = 0;
+    insert(text);
+};
@@ -0,0 +1,113 @@
+#ifndef CLASS_LINE_EDITOR
+#define CLASS_LINE_EDITOR
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ConsoleWriter {
+    // The input line: a gap buffer with command history and a horizontal
+    // view for lines wider than the terminal.
+    //
+    // Edits at the cursor are O(1) amortised, and moving the cursor only
+    // shifts the text between its old and new position. render() compares
+    // the visible cells with those it drew last time and only redraws the
+    // cells that changed.
+    class LineEditor {
+    public:
+	static constexpr size_t HISTORY_SIZE { 1000 };
+
+	LineEditor();
+
+	void insert(std::string_view text);
+	void erase_before() noexcept;
+	void erase_after() noexcept;
+
+	void move_left() noexcept;
+	void move_right() noexcept;
+	void move_home() noexcept;
+	void move_end() noexcept;
+
+	void history_previous();
+	void history_next();
+
+	// returns the line, records it in the history and clears the editor
+	std::string commit();
+
+	size_t cursor() const noexcept { return _gap_start; }
+	size_t size() const noexcept {
+	    return _buffer.size() - (_gap_end - _gap_start);
+	}
+	char at(size_t const index) const noexcept {
+	    return index < _gap_start ? _buffer[index] :
+		_buffer[index + (_gap_end - _gap_start)];
+	}
+	std::string text() const;
+
+	// forget what was drawn so the next render repaints every cell
+	void invalidate() noexcept { _drawn.clear(); }
+
+	// calls draw_cell(column, character, is_cursor) for each cell of a
+	// width-wide view that differs from the previous render
+	template <typename DrawCell>
+	void render(size_t const width, DrawCell&& draw_cell);
+    private:
+	struct Cell {
+	    char _character;
+	    bool _cursor;
+
+	    bool operator==(Cell const& other) const noexcept {
+		return _character == other._character &&
+		    _cursor == other._cursor;
+	    }
+	};
+
+	void move_gap(size_t const position) noexcept;
+	void reserve_gap(size_t const length);
+	void replace(std::string_view text);
+
+	std::vector<char> _buffer;
+	size_t _gap_start { 0 };
+	size_t _gap_end { 0 };
+
+	std::deque<std::string> _history;
+	size_t _history_index { 0 };
+	std::string _draft;
+
+	size_t _scroll { 0 };
+	std::vector<Cell> _drawn;
+    };
+};
+
+template <typename DrawCell>
+void
+ConsoleWriter::LineEditor::render
+(size_t const width, DrawCell&& draw_cell) {
+    if (width == 0) {
+	return;
+    };
+    // keep the cursor inside the view, scrolling as little as possible
+    const size_t cursor_column = cursor();
+    if (cursor_column < _scroll) {
+	_scroll = cursor_column;
+    } else if (cursor_column >= _scroll + width) {
+	_scroll = cursor_column - width + 1;
+    };
+    if (_drawn.size() != width) {
+	_drawn.assign(width, Cell { '\0', false });
+    };
+    const size_t length = size();
+    for (size_t column = 0; column < width; ++column) {
+	const size_t index = _scroll + column;
+	const Cell cell { index < length ? at(index) : ' ',
+			  index == cursor_column };
+	if (!(cell == _drawn[column])) {
+	    draw_cell(column, cell._character, cell._cursor);
+	    _drawn[column] = cell;
+	};
+    };
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "log_level.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace {
+    using ConsoleWriter::Channel;
+    using ConsoleWriter::LogLevel;
+
+    // 0 follows the default, otherwise the level + 1, so the table
+    // starts zeroed
+    std::atomic<uint8_t> _channel_levels[std::numeric_limits<Channel>::max()
+					 + 1];
+    std::atomic<uint8_t> _default_level {
+	static_cast<uint8_t>(LogLevel::INFO) };
+
+    // the levels set, for finding the lowest
+    std::mutex _levels_lock;
+    std::map<Channel, LogLevel> _set_levels;
+
+    constexpr std::string_view NAMES[] {
+	"trace", "debug", "info", "warning", "error", "off"
+    };
+
+    // with _levels_lock held
+    void
+    update_lowest
+    () {
+	uint8_t lowest = _default_level.load(std::memory_order_relaxed);
+	for (auto const& [channel, level] : _set_levels) {
+	    lowest = std::min(lowest, static_cast<uint8_t>(level));
+	};
+	ConsoleWriter::_lowest_log_level.store(lowest,
+					       std::memory_order_relaxed);
+    };
+};
+
+void
+ConsoleWriter::set_log_level
+(LogLevel const level) noexcept {
+    std::scoped_lock<std::mutex> lock(_levels_lock);
+    _default_level.store(static_cast<uint8_t>(level),
+			 std::memory_order_relaxed);
+    update_lowest();
+};
+
+void
+ConsoleWriter::set_log_level
+(Channel const channel, LogLevel const level) noexcept {
+    std::scoped_lock<std::mutex> lock(_levels_lock);
+    _set_levels[channel] = level;
+    _channel_levels[channel].store(static_cast<uint8_t>(level) + 1,
+				   std::memory_order_relaxed);
+    update_lowest();
+};
+
+void
+ConsoleWriter::clear_log_level
+(Channel const channel) noexcept {
+    std::scoped_lock<std::mutex> lock(_levels_lock);
+    _set_levels.erase(channel);
+    _channel_levels[channel].store(0, std::memory_order_relaxed);
+    update_lowest();
+};
+
+ConsoleWriter::LogLevel
+ConsoleWriter::log_level
+() noexcept {
+    return static_cast<LogLevel>
+	(_default_level.load(std::memory_order_relaxed));
+};
+
+ConsoleWriter::LogLevel
+ConsoleWriter::log_level
+(Channel const channel) noexcept {
+    const uint8_t own = _channel_levels[channel]
+	.load(std::memory_order_relaxed);
+    return own == 0 ? log_level() : static_cast<LogLevel>(own - 1);
+};
+
+bool
+ConsoleWriter::channel_logs
+(LogLevel const level, Channel const channel) noexcept {
+    return level >= log_level(channel);
+};
+
+std::vector<std::pair<ConsoleWriter::Channel, ConsoleWriter::LogLevel>>
+ConsoleWriter::channel_log_levels
+() {
+    std::scoped_lock<std::mutex> lock(_levels_lock);
+    return { _set_levels.begin(), _set_levels.end() };
+};
+
+std::string_view
+ConsoleWriter::log_level_name
+(LogLevel const level) noexcept {
+    return NAMES[static_cast<size_t>(level)];
+};
+
+std::optional<ConsoleWriter::LogLevel>
+ConsoleWriter::parse_log_level
+(std::string_view name) noexcept {
+    auto matches = [name] (std::string_view const level) {
+	return std::equal(name.begin(), name.end(), level.begin(), level.end(),
+			  [] (unsigned char const a, unsigned char const b) {
+			      return std::tolower(a) == b;
+			  });
+    };
+    if (matches("warn")) {
+	return LogLevel::WARNING;
+    };
+    for (size_t i = 0; i < std::size(NAMES); ++i) {
+	if (matches(NAMES[i])) {
+	    return static_cast<LogLevel>(i);
+	};
+    };
+    return std::nullopt;
+};
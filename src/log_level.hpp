@@ -0,0 +1,80 @@
+#ifndef NAMESPACE_LOG_LEVEL
+#define NAMESPACE_LOG_LEVEL
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "channel.hpp"
+
+// The lowest level compiled in, 0 (trace) to 5 (off). CONSOLE_LOG calls
+// below it are discarded by the compiler, arguments and all, so release
+// builds can leave trace calls in hot loops, e.g. -DCONSOLE_LOG_LEVEL=2
+// keeps info and above
+#ifndef CONSOLE_LOG_LEVEL
+#ifdef NDEBUG
+#define CONSOLE_LOG_LEVEL 2
+#else
+#define CONSOLE_LOG_LEVEL 0
+#endif
+#endif
+
+namespace ConsoleWriter {
+    enum class LogLevel : uint8_t {
+	TRACE,
+	DEBUG,
+	INFO,
+	WARNING,
+	ERROR,
+	OFF
+    };
+
+    constexpr LogLevel COMPILED_LOG_LEVEL {
+	static_cast<LogLevel>(CONSOLE_LOG_LEVEL) };
+    static_assert(COMPILED_LOG_LEVEL <= LogLevel::OFF,
+		  "CONSOLE_LOG_LEVEL runs from 0 (trace) to 5 (off)");
+
+    // Levels are also set at runtime, for every channel or for one. A
+    // channel without its own level follows the default, INFO to start.
+    // Thread safe
+    void set_log_level(LogLevel const level) noexcept;
+    void set_log_level(Channel const channel, LogLevel const level) noexcept;
+    // back to following the default
+    void clear_log_level(Channel const channel) noexcept;
+    LogLevel log_level() noexcept;
+    LogLevel log_level(Channel const channel) noexcept;
+    // the channels with a level of their own
+    std::vector<std::pair<Channel, LogLevel>> channel_log_levels();
+
+    std::string_view log_level_name(LogLevel const level) noexcept;
+    // case-insensitive, "warn" for WARNING
+    std::optional<LogLevel> parse_log_level(std::string_view name) noexcept;
+
+    // the lowest level any channel shows, so most disabled calls cost one
+    // relaxed load
+    inline std::atomic<uint8_t> _lowest_log_level {
+	static_cast<uint8_t>(LogLevel::INFO) };
+
+    // the channel's own level, for calls that passed might_log()
+    bool channel_logs(LogLevel const level, Channel const channel) noexcept;
+
+    // false means no channel shows level
+    inline bool
+    might_log
+    (LogLevel const level) noexcept {
+	return level >= COMPILED_LOG_LEVEL && level != LogLevel::OFF &&
+	    static_cast<uint8_t>(level) >=
+	    _lowest_log_level.load(std::memory_order_relaxed);
+    };
+
+    inline bool
+    log_enabled
+    (LogLevel const level, Channel const channel) noexcept {
+	return might_log(level) && channel_logs(level, channel);
+    };
+};
+
+#endif
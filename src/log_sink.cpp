@@ -0,0 +1,314 @@
+#include "log_sink.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "timestamp.hpp"
+
+namespace {
+    char SPACE[] { ' ' };
+    char NEWLINE[] { '\n' };
+
+#ifdef IOV_MAX
+    constexpr size_t MAX_VECTORS { IOV_MAX };
+#else
+    constexpr size_t MAX_VECTORS { 1024 };
+#endif
+
+    char*
+    put
+    (char* out, uint64_t value, size_t const bytes) noexcept {
+	for (size_t i = 0; i < bytes; ++i) {
+	    out[i] = static_cast<char>(value & 0xff);
+	    value >>= 8;
+	};
+	return out + bytes;
+    };
+
+    iovec
+    vector_of
+    (void const* data, size_t const size) noexcept {
+	return iovec { const_cast<void*>(data), size };
+    };
+
+    std::string
+    rotated_path
+    (std::string const& path, size_t const index) {
+	return path + "." + std::to_string(index);
+    };
+};
+
+ConsoleWriter::LogSink::LogSink
+(LogSinkOptions options)
+    : ThreadedProcess()
+    , _options(std::move(options))
+    , _message_queue(_options._queue_capacity) {
+    _batch.reserve(BATCH_MESSAGES);
+    _headers.resize(BATCH_MESSAGES * HEADER_BYTES);
+    _vectors.reserve(MAX_VECTORS);
+    open_file();
+    launch();
+};
+
+ConsoleWriter::LogSink::~LogSink
+() {
+    shutdown();
+    join();
+};
+
+void
+ConsoleWriter::LogSink::start
+() {
+    _running = true;
+    if (_options._execution_mode == ExecutionMode::COOPERATIVE) {
+	start_cooperative();
+	return;
+    };
+    _thread = std::make_shared<std::thread>([&] () { this->run_sink(); });
+};
+
+bool
+ConsoleWriter::LogSink::write
+(Message const& message) noexcept {
+    Message copy(message);
+    if (!_message_queue.try_push(std::move(copy))) {
+	_dropped.fetch_add(1, std::memory_order_relaxed);
+	return false;
+    };
+    // only the push that fills half a batch wakes the sink; anything
+    // smaller goes out on the next flush interval
+    if (_message_queue.size_approx() == WAKE_THRESHOLD) {
+	if (_task) {
+	    resume();
+	} else {
+	    _wake_cv.notify_one();
+	};
+    };
+    return true;
+};
+
+void
+ConsoleWriter::LogSink::on_shutdown
+() noexcept {
+    std::scoped_lock<std::mutex> lock(_wake_lock);
+    _wake_cv.notify_all();
+};
+
+void
+ConsoleWriter::LogSink::run_sink
+() {
+    while (_running) {
+	{
+	    std::unique_lock<std::mutex> lock(_wake_lock);
+	    _wake_cv.wait_for(lock, FLUSH_INTERVAL, [&] () {
+		return _message_queue.size_approx() >= WAKE_THRESHOLD ||
+		    !_running;
+	    });
+	}
+	drain();
+	rotate_if_due();
+    };
+    drain();
+    close_file();
+    set_deletable();
+};
+
+bool
+ConsoleWriter::LogSink::run_once
+() {
+    if (_deletable) {
+	return false;
+    };
+    if (!_running) {
+	drain();
+	close_file();
+	set_deletable();
+	return false;
+    };
+    drain();
+    rotate_if_due();
+    resume_at(std::chrono::steady_clock::now() + FLUSH_INTERVAL);
+    return false;
+};
+
+void
+ConsoleWriter::LogSink::drain
+() noexcept {
+    while (true) {
+	_batch.clear();
+	_message_queue.pop_batch([&] (Message&& message) {
+	    _batch.push_back(std::move(message));
+	}, BATCH_MESSAGES);
+	if (_batch.empty()) {
+	    return;
+	};
+	write_batch();
+	_written.fetch_add(_batch.size(), std::memory_order_relaxed);
+	rotate_if_due();
+    };
+};
+
+void
+ConsoleWriter::LogSink::write_batch
+() noexcept {
+    const size_t per_message = 2 + 2 * Message::MAX_CHUNKS;
+    _vectors.clear();
+    for (size_t i = 0; i < _batch.size(); ++i) {
+	if (_vectors.size() + per_message > MAX_VECTORS) {
+	    write_all(_vectors.data(), _vectors.size());
+	    _vectors.clear();
+	};
+	iovec* out = _vectors.data() + _vectors.size();
+	_vectors.resize(_vectors.size() + per_message);
+	char* header = _headers.data() + i * HEADER_BYTES;
+	const size_t used = _options._format == LogFormat::TEXT ?
+	    encode_text(_batch[i], header, out) :
+	    encode_binary(_batch[i], header, out);
+	_vectors.resize(_vectors.size() - per_message + used);
+    };
+    if (!_vectors.empty()) {
+	write_all(_vectors.data(), _vectors.size());
+    };
+};
+
+size_t
+ConsoleWriter::LogSink::encode_text
+(Message const& message, char* header, iovec* vectors) noexcept {
+    size_t count = 0;
+    if (message.has_timestamp()) {
+	const size_t length = Timestamp::format(message._enqueued, true,
+						header);
+	header[length] = ' ';
+	vectors[count++] = vector_of(header, length + 1);
+    };
+    for (size_t i = 0; i < message.chunk_count(); ++i) {
+	const Message::Chunk chunk = message.chunk(i);
+	if (i != 0) {
+	    vectors[count++] = vector_of(SPACE, 1);
+	};
+	vectors[count++] = vector_of(chunk._text.data(), chunk._text.size());
+    };
+    vectors[count++] = vector_of(NEWLINE, 1);
+    return count;
+};
+
+size_t
+ConsoleWriter::LogSink::encode_binary
+(Message const& message, char* header, iovec* vectors) noexcept {
+    using namespace std::chrono;
+    const size_t chunks = message.chunk_count();
+    const size_t header_size = 4 + 8 + 2 + 5 * chunks;
+    const int64_t wall = duration_cast<nanoseconds>
+	(Timestamp::to_wall(message._enqueued).time_since_epoch()).count();
+    char* out = put(header, header_size - 4 + message.text_size(), 4);
+    out = put(out, static_cast<uint64_t>(wall), 8);
+    *out++ = static_cast<char>(message.has_timestamp() ?
+			       LogFile::TIMESTAMPED : 0);
+    *out++ = static_cast<char>(chunks);
+    size_t count = 0;
+    vectors[count++] = vector_of(header, header_size);
+    for (size_t i = 0; i < chunks; ++i) {
+	const Message::Chunk chunk = message.chunk(i);
+	*out++ = static_cast<char>(chunk._colour);
+	out = put(out, chunk._text.size(), 4);
+	vectors[count++] = vector_of(chunk._text.data(), chunk._text.size());
+    };
+    return count;
+};
+
+bool
+ConsoleWriter::LogSink::write_all
+(iovec* vectors, size_t count) noexcept {
+    while (count > 0 && _fd >= 0) {
+	const ssize_t written = ::writev(_fd, vectors,
+					 static_cast<int>(count));
+	if (written < 0) {
+	    if (errno == EINTR) {
+		continue;
+	    };
+	    _write_errors.fetch_add(1, std::memory_order_relaxed);
+	    return false;
+	};
+	_file_bytes += static_cast<size_t>(written);
+	// skip whatever went out and carry on from a partial write
+	size_t remaining = static_cast<size_t>(written);
+	while (count > 0 && remaining >= vectors->iov_len) {
+	    remaining -= vectors->iov_len;
+	    ++vectors;
+	    --count;
+	};
+	if (count > 0) {
+	    vectors->iov_base = static_cast<char*>(vectors->iov_base) +
+		remaining;
+	    vectors->iov_len -= remaining;
+	};
+    };
+    return true;
+};
+
+void
+ConsoleWriter::LogSink::open_file
+() {
+    _fd = ::open(_options._path.c_str(),
+		 O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+	throw std::runtime_error("cannot open log file " + _options._path +
+				 ": " + std::strerror(errno));
+    };
+    const off_t size = ::lseek(_fd, 0, SEEK_END);
+    _file_bytes = size > 0 ? static_cast<size_t>(size) : 0;
+    _opened = std::chrono::steady_clock::now();
+    if (_options._format == LogFormat::BINARY && _file_bytes == 0) {
+	char header[8];
+	std::memcpy(header, LogFile::MAGIC, 4);
+	put(header + 4, LogFile::VERSION, 4);
+	iovec vector = vector_of(header, sizeof(header));
+	write_all(&vector, 1);
+    };
+};
+
+void
+ConsoleWriter::LogSink::close_file
+() noexcept {
+    if (_fd < 0) {
+	return;
+    };
+    ::fdatasync(_fd);
+    ::close(_fd);
+    _fd = -1;
+};
+
+void
+ConsoleWriter::LogSink::rotate_if_due
+() noexcept {
+    const bool too_big = _options._max_bytes > 0 &&
+	_file_bytes >= _options._max_bytes;
+    const bool too_old = _options._max_age.count() > 0 &&
+	std::chrono::steady_clock::now() - _opened >= _options._max_age;
+    // an empty file is never rotated just for its age
+    if (!too_big && !(too_old && _file_bytes > 0)) {
+	return;
+    };
+    close_file();
+    if (_options._max_files == 0) {
+	::unlink(_options._path.c_str());
+    } else {
+	for (size_t i = _options._max_files; i > 1; --i) {
+	    std::rename(rotated_path(_options._path, i - 1).c_str(),
+			rotated_path(_options._path, i).c_str());
+	};
+	std::rename(_options._path.c_str(),
+		    rotated_path(_options._path, 1).c_str());
+    };
+    try {
+	open_file();
+    } catch (std::exception const&) {
+	_write_errors.fetch_add(1, std::memory_order_relaxed);
+    };
+};
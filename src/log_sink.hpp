@@ -0,0 +1,121 @@
+#ifndef CLASS_LOG_SINK
+#define CLASS_LOG_SINK
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "message.hpp"
+#include "mpsc_queue.hpp"
+#include "threaded_process.hpp"
+
+struct iovec;
+
+namespace ConsoleWriter {
+    enum class LogFormat {
+	// one "[timestamp] chunk chunk" line per message
+	TEXT,
+	// compact records, read back with the log_decode tool
+	BINARY
+    };
+
+    struct LogSinkOptions {
+	std::string _path;
+	LogFormat _format { LogFormat::TEXT };
+	// a file is rotated once it passes either limit; 0 disables one
+	size_t _max_bytes { 64 << 20 };
+	std::chrono::seconds _max_age { 0 };
+	// rotated files are kept as path.1 (newest) to path.N
+	size_t _max_files { 8 };
+	size_t _queue_capacity { 16384 };
+	// COOPERATIVE runs the sink on ProcessExecutor::shared() rather
+	// than a thread of its own
+	ExecutionMode _execution_mode { ExecutionMode::DEDICATED_THREAD };
+    };
+
+    // Binary log layout, all integers little-endian:
+    //
+    //     file:    "FBLG" u32 version
+    //     record:  u32 size of the rest of the record
+    //              i64 wall-clock nanoseconds since the epoch
+    //              u8  flags (bit 0: the line is drawn with its timestamp)
+    //              u8  chunk count
+    //              per chunk: u8 colour, u32 length
+    //              the chunks' text, back to back
+    namespace LogFile {
+	static constexpr char MAGIC[4] { 'F', 'B', 'L', 'G' };
+	static constexpr uint32_t VERSION { 1 };
+	static constexpr uint8_t TIMESTAMPED { 1 };
+    };
+
+    // Persists console messages on its own thread.
+    //
+    // The console thread hands over a copy of each message it draws with
+    // write(), which never blocks: if the sink falls a whole queue behind
+    // the message is counted as dropped. The sink thread wakes when a
+    // batch has built up or every FLUSH_INTERVAL, and writes the whole
+    // batch with one writev whose vectors point straight at the messages'
+    // text. Files are synced only when they are rotated or closed.
+    // In COOPERATIVE mode the same wakeups resume a task on the shared
+    // executor instead.
+    class LogSink final : public ThreadedProcess {
+    public:
+	// throws std::runtime_error if the file cannot be opened
+	explicit LogSink(LogSinkOptions options);
+	~LogSink();
+
+	// PURE VIRTUAL FUNCTIONS
+	std::string process_name() const noexcept override { return "LogSink"; }
+	void start() override;
+	// END OF PURE VIRTUAL FUNCTIONS
+
+	bool write(Message const& message) noexcept;
+
+	size_t written() const noexcept { return _written.load(); }
+	size_t dropped() const noexcept { return _dropped.load(); }
+	size_t write_errors() const noexcept { return _write_errors.load(); }
+    private:
+	static constexpr size_t BATCH_MESSAGES { 256 };
+	static constexpr size_t WAKE_THRESHOLD { BATCH_MESSAGES / 2 };
+	static constexpr std::chrono::milliseconds FLUSH_INTERVAL { 100 };
+	// the widest per-message header in either format
+	static constexpr size_t HEADER_BYTES { 16 + 5 * Message::MAX_CHUNKS };
+
+	void run_sink();
+	bool run_once() override;
+	void on_shutdown() noexcept override;
+	void drain() noexcept;
+	void write_batch() noexcept;
+	size_t encode_text(Message const& message, char* header,
+			   iovec* vectors) noexcept;
+	size_t encode_binary(Message const& message, char* header,
+			     iovec* vectors) noexcept;
+	bool write_all(iovec* vectors, size_t count) noexcept;
+	void open_file();
+	void close_file() noexcept;
+	void rotate_if_due() noexcept;
+
+	LogSinkOptions const _options;
+	MpscQueue<Message> _message_queue;
+	std::mutex _wake_lock;
+	std::condition_variable _wake_cv;
+
+	// owned by the sink thread, or whichever worker runs the sink
+	int _fd { -1 };
+	size_t _file_bytes { 0 };
+	std::chrono::steady_clock::time_point _opened;
+	std::vector<Message> _batch;
+	std::vector<char> _headers;
+	std::vector<iovec> _vectors;
+
+	std::atomic<size_t> _written { 0 };
+	std::atomic<size_t> _dropped { 0 };
+	std::atomic<size_t> _write_errors { 0 };
+    };
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include "memory_renderer.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+ConsoleWriter::MemoryRenderer::MemoryRenderer
+(int const rows, int const columns)
+    : _rows(rows)
+    , _columns(columns)
+    , _input(static_cast<size_t>(columns), ' ') {
+    layout(1);
+};
+
+void
+ConsoleWriter::MemoryRenderer::layout
+(size_t const count) noexcept {
+    const auto rows = split_rows(_rows - static_cast<int>(_status_rows),
+				 count);
+    _panes.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+	_panes[i]._rows = rows[i];
+	_panes[i]._log.clear();
+	_panes[i]._title.clear();
+    };
+};
+
+size_t
+ConsoleWriter::MemoryRenderer::max_panes
+() const noexcept {
+    return split_rows(_rows - static_cast<int>(_status_rows),
+		      static_cast<size_t>(_rows)).size();
+};
+
+void
+ConsoleWriter::MemoryRenderer::set_panes
+(size_t const count) noexcept {
+    layout(count);
+};
+
+void
+ConsoleWriter::MemoryRenderer::draw_pane_title
+(size_t const pane, std::string const& title) noexcept {
+    if (pane < _panes.size()) {
+	_panes[pane]._title = title.substr(0, static_cast<size_t>(_columns));
+    };
+};
+
+int
+ConsoleWriter::MemoryRenderer::log_rows
+(size_t const pane) const noexcept {
+    return pane < _panes.size() ? _panes[pane]._rows : 1;
+};
+
+void
+ConsoleWriter::MemoryRenderer::append_line
+(size_t const pane, Message const& message) noexcept {
+    if (pane >= _panes.size()) {
+	return;
+    };
+    std::string line = plain_text(message);
+    auto& log = _panes[pane]._log;
+    const size_t rows = static_cast<size_t>(_panes[pane]._rows);
+    while (!log.empty() && log.size() >= rows) {
+	log.erase(log.begin());
+    };
+    log.push_back(line);
+    if (pane == 0) {
+	_appended.push_back(std::move(line));
+    };
+};
+
+void
+ConsoleWriter::MemoryRenderer::draw_log_page
+(size_t const pane, RingBuffer<Message> const& history,
+ size_t const end) noexcept {
+    if (pane >= _panes.size()) {
+	return;
+    };
+    auto& log = _panes[pane]._log;
+    const size_t rows = static_cast<size_t>(_panes[pane]._rows);
+    const size_t last = end < history.size() ? end : history.size();
+    const size_t first = last > rows ? last - rows : 0;
+    log.clear();
+    for (size_t i = first; i < last; ++i) {
+	log.push_back(plain_text(history[i]));
+    };
+};
+
+void
+ConsoleWriter::MemoryRenderer::draw_separator
+(std::string const& label) noexcept {
+    _drawn_separator = label;
+};
+
+void
+ConsoleWriter::MemoryRenderer::set_status_rows
+(size_t const rows) noexcept {
+    // the log always keeps a row
+    _status_rows = std::min(rows, static_cast<size_t>(_rows - 1));
+    _drawn_status.resize(_status_rows);
+    layout(_panes.size());
+};
+
+void
+ConsoleWriter::MemoryRenderer::draw_status_row
+(size_t const row, std::string const& text) noexcept {
+    if (row < _drawn_status.size()) {
+	_drawn_status[row] = text.substr(0, static_cast<size_t>(_columns));
+    };
+};
+
+void
+ConsoleWriter::MemoryRenderer::draw_input_cell
+(size_t const column, char const character, bool const is_cursor) noexcept {
+    if (column < _input.size()) {
+	_input[column] = character;
+    };
+    if (is_cursor) {
+	_drawn_cursor = column;
+    };
+};
+
+void
+ConsoleWriter::MemoryRenderer::present
+() noexcept {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    _screens.resize(_panes.size());
+    _titles.resize(_panes.size());
+    for (size_t i = 0; i < _panes.size(); ++i) {
+	_screens[i] = _panes[i]._log;
+	_titles[i] = _panes[i]._title;
+    };
+    for (auto& line : _appended) {
+	_lines.push_back(std::move(line));
+    };
+    _appended.clear();
+    _separator = _drawn_separator;
+    _status = _drawn_status;
+    _input_line = _input;
+    _cursor = _drawn_cursor;
+    ++_frames;
+};
+
+bool
+ConsoleWriter::MemoryRenderer::wait_for_key
+(int const timeout_ms) noexcept {
+    std::unique_lock<std::mutex> lock(_key_lock);
+    return _key_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+			    [&] () { return !_keys.empty(); });
+};
+
+int
+ConsoleWriter::MemoryRenderer::read_key
+() noexcept {
+    std::scoped_lock<std::mutex> lock(_key_lock);
+    if (_keys.empty()) {
+	return NO_KEY;
+    };
+    const int key = _keys.front();
+    _keys.pop_front();
+    return key;
+};
+
+void
+ConsoleWriter::MemoryRenderer::push_keys
+(std::string_view keys) {
+    {
+	std::scoped_lock<std::mutex> lock(_key_lock);
+	for (char const c : keys) {
+	    _keys.push_back(static_cast<unsigned char>(c));
+	};
+    }
+    _key_cv.notify_one();
+};
+
+void
+ConsoleWriter::MemoryRenderer::push_key
+(int const key) {
+    {
+	std::scoped_lock<std::mutex> lock(_key_lock);
+	_keys.push_back(key);
+    }
+    _key_cv.notify_one();
+};
+
+std::vector<std::string>
+ConsoleWriter::MemoryRenderer::screen
+(size_t const pane) const {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    return pane < _screens.size() ? _screens[pane] :
+	std::vector<std::string>();
+};
+
+std::vector<std::string>
+ConsoleWriter::MemoryRenderer::pane_titles
+() const {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    return _titles;
+};
+
+std::vector<std::string>
+ConsoleWriter::MemoryRenderer::lines
+() const {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    return _lines;
+};
+
+std::string
+ConsoleWriter::MemoryRenderer::separator
+() const {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    return _separator;
+};
+
+std::vector<std::string>
+ConsoleWriter::MemoryRenderer::status
+() const {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    return _status;
+};
+
+std::string
+ConsoleWriter::MemoryRenderer::input_line
+() const {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    return _input_line;
+};
+
+size_t
+ConsoleWriter::MemoryRenderer::cursor
+() const {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    return _cursor;
+};
+
+size_t
+ConsoleWriter::MemoryRenderer::frames
+() const {
+    std::scoped_lock<std::mutex> lock(_screen_lock);
+    return _frames;
+};
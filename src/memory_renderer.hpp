@@ -0,0 +1,98 @@
+#ifndef CLASS_MEMORY_RENDERER
+#define CLASS_MEMORY_RENDERER
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "renderer.hpp"
+
+namespace ConsoleWriter {
+    // Keeps the screen as plain text so tests can drive a console with
+    // scripted keys and read back exactly what it would have shown. The
+    // accessors return copies and may be called from any thread.
+    class MemoryRenderer final : public Renderer {
+    public:
+	explicit MemoryRenderer(int const rows = 24, int const columns = 80);
+
+	size_t max_panes() const noexcept override;
+	void set_panes(size_t const count) noexcept override;
+	void draw_pane_title(size_t const pane,
+			     std::string const& title) noexcept override;
+
+	int log_rows(size_t const pane) const noexcept override;
+	int columns() const noexcept override { return _columns; }
+
+	void append_line(size_t const pane,
+			 Message const& message) noexcept override;
+	void draw_log_page(size_t const pane,
+			   RingBuffer<Message> const& history,
+			   size_t const end) noexcept override;
+	void draw_separator(std::string const& label) noexcept override;
+	void set_status_rows(size_t const rows) noexcept override;
+	void draw_status_row(size_t const row,
+			     std::string const& text) noexcept override;
+	void draw_input_cell(size_t const column, char const character,
+			     bool const is_cursor) noexcept override;
+	void present() noexcept override;
+
+	bool accepts_input() const noexcept override { return true; }
+	bool wait_for_key(int const timeout_ms) noexcept override;
+	int read_key() noexcept override;
+
+	// queue keys as if typed; each character is one key
+	void push_keys(std::string_view keys);
+	void push_key(int const key);
+
+	// a pane's log rows as they were at the last present()
+	std::vector<std::string> screen(size_t const pane = 0) const;
+	std::vector<std::string> pane_titles() const;
+	// every line ever appended to the first pane, oldest first
+	std::vector<std::string> lines() const;
+	std::string separator() const;
+	std::vector<std::string> status() const;
+	std::string input_line() const;
+	size_t cursor() const;
+	size_t frames() const;
+    private:
+	int const _rows;
+	int const _columns;
+	size_t _status_rows { 0 };
+
+	struct Pane {
+	    int _rows;
+	    std::vector<std::string> _log;
+	    std::string _title;
+	};
+
+	void layout(size_t const count) noexcept;
+
+	// drawn by the console thread between presents
+	std::vector<Pane> _panes;
+	std::string _input;
+	std::string _drawn_separator;
+	std::vector<std::string> _drawn_status;
+	size_t _drawn_cursor { 0 };
+	std::vector<std::string> _appended;
+
+	// published at present()
+	mutable std::mutex _screen_lock;
+	std::vector<std::vector<std::string>> _screens;
+	std::vector<std::string> _titles;
+	std::vector<std::string> _lines;
+	std::string _separator;
+	std::vector<std::string> _status;
+	std::string _input_line;
+	size_t _cursor { 0 };
+	size_t _frames { 0 };
+
+	std::mutex _key_lock;
+	std::condition_variable _key_cv;
+	std::deque<int> _keys;
+    };
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "message.hpp"
+#include "message_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+ConsoleWriter::Message::Message
+(size_t const reserve_bytes) {
+    reserve(reserve_bytes);
+};
+
+ConsoleWriter::Message::~Message
+() {
+    release();
+};
+
+ConsoleWriter::Message::Message
+(Message const& other)
+    : _enqueued(other._enqueued)
+    , _source(other._source)
+    , _channel(other._channel)
+    , _chunk_count(other._chunk_count)
+    , _timestamped(other._timestamped) {
+    reserve(other._size);
+    if (other._size > 0) {
+	std::memcpy(_data, other._data, other._size);
+    };
+    _size = other._size;
+    std::copy(other._spans, other._spans + other._chunk_count, _spans);
+};
+
+ConsoleWriter::Message::Message
+(Message&& other) noexcept
+    : _enqueued(other._enqueued)
+    , _source(other._source)
+    , _channel(other._channel)
+    , _data(std::exchange(other._data, nullptr))
+    , _size(std::exchange(other._size, 0))
+    , _capacity(std::exchange(other._capacity, 0))
+    , _chunk_count(std::exchange(other._chunk_count, 0))
+    , _timestamped(other._timestamped) {
+    std::copy(other._spans, other._spans + _chunk_count, _spans);
+};
+
+ConsoleWriter::Message&
+ConsoleWriter::Message::operator=
+(Message const& other) {
+    if (this != &other) {
+	Message copy(other);
+	*this = std::move(copy);
+    };
+    return *this;
+};
+
+ConsoleWriter::Message&
+ConsoleWriter::Message::operator=
+(Message&& other) noexcept {
+    if (this != &other) {
+	release();
+	_enqueued = other._enqueued;
+	_source = other._source;
+	_channel = other._channel;
+	_data = std::exchange(other._data, nullptr);
+	_size = std::exchange(other._size, 0);
+	_capacity = std::exchange(other._capacity, 0);
+	_chunk_count = std::exchange(other._chunk_count, 0);
+	_timestamped = other._timestamped;
+	std::copy(other._spans, other._spans + _chunk_count, _spans);
+    };
+    return *this;
+};
+
+void
+ConsoleWriter::Message::add_chunk
+(std::string_view msg, int const colour) {
+    const uint8_t clamped = static_cast<uint8_t>
+	((colour >= COLOURS_COUNT || colour < NORMAL) ? NORMAL : colour);
+    if (_size + msg.size() > _capacity) {
+	reserve(std::max<size_t>(_size + msg.size(), _capacity * 2));
+    };
+    if (!msg.empty()) {
+	std::memcpy(_data + _size, msg.data(), msg.size());
+    };
+    if (_chunk_count < MAX_CHUNKS) {
+	_spans[_chunk_count++] = Span { _size,
+					static_cast<uint32_t>(msg.size()),
+					clamped };
+    } else {
+	_spans[MAX_CHUNKS - 1]._length += static_cast<uint32_t>(msg.size());
+    };
+    _size += static_cast<uint32_t>(msg.size());
+};
+
+ConsoleWriter::Message::Chunk
+ConsoleWriter::Message::chunk
+(size_t const index) const noexcept {
+    const Span& span = _spans[index];
+    return Chunk { std::string_view(_data + span._offset, span._length),
+		   span._colour };
+};
+
+uint64_t
+ConsoleWriter::Message::hash
+() const noexcept {
+    constexpr uint64_t PRIME { 1099511628211ull };
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < _chunk_count; ++i) {
+	const Span& span = _spans[i];
+	hash = (hash ^ span._colour) * PRIME;
+	for (uint32_t j = 0; j < span._length; ++j) {
+	    hash = (hash ^ static_cast<unsigned char>
+		    (_data[span._offset + j])) * PRIME;
+	};
+	// keep "ab" + "c" apart from "a" + "bc"
+	hash = (hash ^ 0xff) * PRIME;
+    };
+    return hash;
+};
+
+uint32_t
+ConsoleWriter::Message::current_source
+() noexcept {
+    static std::atomic<uint32_t> next { 1 };
+    thread_local const uint32_t source =
+	next.fetch_add(1, std::memory_order_relaxed);
+    return source;
+};
+
+void
+ConsoleWriter::Message::reserve
+(size_t const bytes) {
+    if (bytes <= _capacity) {
+	return;
+    };
+    size_t capacity = bytes;
+    char* data = MessagePool::allocate(capacity);
+    if (_size > 0) {
+	std::memcpy(data, _data, _size);
+    };
+    release();
+    _data = data;
+    _capacity = static_cast<uint32_t>(capacity);
+};
+
+void
+ConsoleWriter::Message::release
+() noexcept {
+    MessagePool::release(_data, _capacity);
+    _data = nullptr;
+    _capacity = 0;
+};
@@ -0,0 +1,89 @@
+#ifndef CLASS_MESSAGE
+#define CLASS_MESSAGE
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include "channel.hpp"
+#include "timestamp.hpp"
+
+namespace ConsoleWriter {
+    // A console line: up to MAX_CHUNKS coloured chunks whose text lives in
+    // one contiguous buffer drawn from MessagePool. The chunk spans are
+    // stored inline, so a typical timestamp + text line costs a single
+    // pooled allocation, which is recycled when the message is destroyed.
+    class Message {
+    public:
+	enum Colours {
+	    NORMAL,
+	    HIGHLIGHT,
+	    ERROR,
+	    TIMESTAMP,
+	    INPUT,
+	    COLOURS_COUNT
+	};
+
+	struct Chunk {
+	    std::string_view _text;
+	    int _colour;
+	};
+
+	static constexpr size_t MAX_CHUNKS { 8 };
+
+	Message() = default;
+	// reserve room for this many bytes of text up front
+	explicit Message(size_t const reserve_bytes);
+	~Message();
+
+	Message(Message const& other);
+	Message(Message&& other) noexcept;
+	Message &operator=(Message const& other);
+	Message &operator=(Message&& other) noexcept;
+
+	// past MAX_CHUNKS the text is appended to the last chunk
+	void add_chunk(std::string_view msg, int const colour);
+
+	size_t chunk_count() const noexcept { return _chunk_count; }
+	Chunk chunk(size_t const index) const noexcept;
+	size_t text_size() const noexcept { return _size; }
+
+	// capture the enqueue time now and draw it as the line's timestamp;
+	// formatting is left to whoever renders the message
+	void stamp() noexcept {
+	    _enqueued = Timestamp::now();
+	    _timestamped = true;
+	}
+	bool has_timestamp() const noexcept { return _timestamped; }
+
+	// FNV-1a over every chunk's colour and text
+	uint64_t hash() const noexcept;
+
+	// a small id per producing thread, for per-source rate limiting
+	static uint32_t current_source() noexcept;
+
+	Timestamp::Clock::time_point _enqueued;
+	// 0 until the console assigns the enqueuing thread's source
+	uint32_t _source { 0 };
+	// MAIN_CHANNEL is replaced by the enqueuing thread's channel
+	Channel _channel { MAIN_CHANNEL };
+    private:
+	struct Span {
+	    uint32_t _offset;
+	    uint32_t _length;
+	    uint8_t _colour;
+	};
+
+	void reserve(size_t const bytes);
+	void release() noexcept;
+
+	char* _data { nullptr };
+	uint32_t _size { 0 };
+	uint32_t _capacity { 0 };
+	uint8_t _chunk_count { 0 };
+	bool _timestamped { false };
+	Span _spans[MAX_CHUNKS];
+    };
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "message_filter.hpp"
+
+#include <algorithm>
+#include <string>
+
+bool
+ConsoleWriter::MessageFilter::admit
+(Message const& message, bool const rate_limited,
+ Clock::time_point const now) {
+    const bool collapse = _settings._duplicate_window.count() > 0;
+    const uint64_t hash = collapse ? message.hash() : 0;
+    if (collapse) {
+	const auto it = _recent.find(hash);
+	if (it != _recent.end() && it->second._expires > now) {
+	    if (it->second._count++ == 0) {
+		it->second._message = message;
+	    };
+	    ++_collapsed;
+	    return false;
+	} else if (it != _recent.end()) {
+	    // the window closed since the last flush
+	    if (it->second._count > 0) {
+		_due.push_back(summary(it->second, it->first));
+		schedule(now);
+	    };
+	    _recent.erase(it);
+	};
+    };
+    if (rate_limited && _settings._rate_per_second > 0.0 &&
+	!take_token(message, now)) {
+	++_rate_limited;
+	return false;
+    };
+    if (collapse && _recent.size() < MAX_TRACKED) {
+	Repeat& repeat = _recent[hash];
+	repeat._expires = now + _settings._duplicate_window;
+	schedule(repeat._expires);
+    };
+    _last_shown = hash;
+    return true;
+};
+
+bool
+ConsoleWriter::MessageFilter::take_token
+(Message const& message, Clock::time_point const now) {
+    const uint32_t source = message._source;
+    auto it = _buckets.find(source);
+    if (it == _buckets.end()) {
+	it = _buckets.emplace(source, Bucket { _settings._burst, now, now })
+	    .first;
+    };
+    Bucket& bucket = it->second;
+    const double elapsed = std::chrono::duration<double>
+	(now - bucket._refilled).count();
+    bucket._tokens = std::min(_settings._burst, bucket._tokens +
+			      elapsed * _settings._rate_per_second);
+    bucket._refilled = now;
+    if (bucket._tokens >= 1.0) {
+	bucket._tokens -= 1.0;
+	return true;
+    };
+    if (bucket._suppressed++ == 0) {
+	bucket._channel = message._channel;
+	schedule(std::max(now, bucket._reported + REPORT_INTERVAL));
+    };
+    return false;
+};
+
+ConsoleWriter::Message
+ConsoleWriter::MessageFilter::summary
+(Repeat const& repeat, uint64_t const hash) const {
+    const std::string count = std::to_string(repeat._count);
+    if (hash == _last_shown) {
+	const std::string text = "last message repeated " + count +
+	    (repeat._count == 1 ? " time" : " times");
+	Message line(text.size());
+	line.stamp();
+	line.add_chunk(text, Message::INPUT);
+	line._channel = repeat._message._channel;
+	return line;
+    };
+    const std::string text = "repeated " + count +
+	(repeat._count == 1 ? " time:" : " times:");
+    Message line(text.size() + repeat._message.text_size());
+    line.stamp();
+    line.add_chunk(text, Message::INPUT);
+    for (size_t i = 0; i < repeat._message.chunk_count(); ++i) {
+	const Message::Chunk chunk = repeat._message.chunk(i);
+	line.add_chunk(chunk._text, chunk._colour);
+    };
+    line._channel = repeat._message._channel;
+    return line;
+};
+
+ConsoleWriter::Message
+ConsoleWriter::MessageFilter::summary
+(uint32_t const source, Bucket const& bucket) const {
+    const std::string text = "rate limit: dropped " +
+	std::to_string(bucket._suppressed) + " messages from source " +
+	std::to_string(source);
+    Message line(text.size());
+    line.stamp();
+    line.add_chunk(text, Message::INPUT);
+    line._channel = bucket._channel;
+    return line;
+};
@@ -0,0 +1,135 @@
+#ifndef CLASS_MESSAGE_FILTER
+#define CLASS_MESSAGE_FILTER
+
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "message.hpp"
+
+namespace ConsoleWriter {
+    // Collapses repeated messages and rate limits noisy sources. Owned by
+    // the console thread, so producers pay nothing for it.
+    //
+    // A message whose hash was shown less than a window ago is held back
+    // and counted; when that window closes one summary line reports how
+    // many repeats were swallowed. Each source (producing thread) has a
+    // token bucket; messages beyond it are counted and reported once per
+    // REPORT_INTERVAL.
+    class MessageFilter {
+    public:
+	using Clock = Timestamp::Clock;
+
+	struct Settings {
+	    // zero disables collapsing
+	    std::chrono::milliseconds _duplicate_window { 1000 };
+	    // zero disables rate limiting
+	    double _rate_per_second { 0.0 };
+	    double _burst { 100.0 };
+	};
+
+	void configure(Settings const& settings) noexcept {
+	    _settings = settings;
+	}
+	Settings const& settings() const noexcept { return _settings; }
+
+	// false when the message should not be shown; only duplicates
+	// are held back for messages that skip the rate limit
+	bool admit(Message const& message, bool const rate_limited,
+		   Clock::time_point const now);
+	// emit(Message&&) for every summary that is due
+	template <typename Emit>
+	void flush(Clock::time_point const now, Emit&& emit);
+	// when the next summary is due, or time_point::max()
+	Clock::time_point next_flush() const noexcept { return _next_flush; }
+
+	size_t collapsed() const noexcept { return _collapsed; }
+	size_t rate_limited() const noexcept { return _rate_limited; }
+    private:
+	static constexpr size_t MAX_TRACKED { 1024 };
+	static constexpr std::chrono::seconds REPORT_INTERVAL { 1 };
+
+	struct Repeat {
+	    Clock::time_point _expires;
+	    size_t _count { 0 };
+	    // a copy of the first swallowed repeat, for the summary line
+	    Message _message;
+	};
+
+	struct Bucket {
+	    double _tokens;
+	    Clock::time_point _refilled;
+	    Clock::time_point _reported;
+	    size_t _suppressed { 0 };
+	    // of the first suppressed message, so the summary reaches the
+	    // same panes
+	    Channel _channel { MAIN_CHANNEL };
+	};
+
+	bool take_token(Message const& message, Clock::time_point const now);
+	Message summary(Repeat const& repeat, uint64_t const hash) const;
+	Message summary(uint32_t const source, Bucket const& bucket) const;
+	void schedule(Clock::time_point const when) noexcept {
+	    if (when < _next_flush) {
+		_next_flush = when;
+	    };
+	}
+
+	Settings _settings;
+	std::unordered_map<uint64_t, Repeat> _recent;
+	std::unordered_map<uint32_t, Bucket> _buckets;
+	std::vector<Message> _due;
+	uint64_t _last_shown { 0 };
+	Clock::time_point _next_flush { Clock::time_point::max() };
+	size_t _collapsed { 0 };
+	size_t _rate_limited { 0 };
+    };
+};
+
+template <typename Emit>
+void
+ConsoleWriter::MessageFilter::flush
+(Clock::time_point const now, Emit&& emit) {
+    if (now < _next_flush) {
+	return;
+    };
+    _next_flush = Clock::time_point::max();
+    for (Message& line : _due) {
+	emit(std::move(line));
+    };
+    _due.clear();
+    for (auto it = _recent.begin(); it != _recent.end(); ) {
+	if (it->second._expires > now) {
+	    schedule(it->second._expires);
+	    ++it;
+	    continue;
+	};
+	if (it->second._count > 0) {
+	    emit(summary(it->second, it->first));
+	};
+	it = _recent.erase(it);
+    };
+    for (auto it = _buckets.begin(); it != _buckets.end(); ) {
+	Bucket& bucket = it->second;
+	if (bucket._suppressed == 0) {
+	    // idle sources are forgotten once their bucket has refilled
+	    const double elapsed = std::chrono::duration<double>
+		(now - bucket._refilled).count();
+	    if (bucket._tokens + elapsed * _settings._rate_per_second >=
+		_settings._burst) {
+		it = _buckets.erase(it);
+		continue;
+	    };
+	} else if (now - bucket._reported >= REPORT_INTERVAL) {
+	    emit(summary(it->first, bucket));
+	    bucket._suppressed = 0;
+	    bucket._reported = now;
+	} else {
+	    schedule(bucket._reported + REPORT_INTERVAL);
+	};
+	++it;
+    };
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "message_pool.hpp"
+
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+    using namespace ConsoleWriter::MessagePool;
+
+    constexpr size_t SIZE_CLASSES { 7 };   // 64 .. 4096
+    constexpr size_t BATCH_SIZE { 32 };
+    constexpr size_t MAX_CACHED_PER_THREAD { BATCH_SIZE * 2 };
+    constexpr size_t MAX_DEPOT_BLOCKS { 4096 };
+
+    struct FreeBlock {
+	FreeBlock* _next;
+    };
+
+    size_t
+    size_class
+    (size_t const capacity) noexcept {
+	size_t index = 0;
+	size_t block = MIN_BLOCK_SIZE;
+	while (block < capacity) {
+	    block <<= 1;
+	    ++index;
+	};
+	return index;
+    };
+
+    constexpr size_t
+    class_size
+    (size_t const index) noexcept {
+	return MIN_BLOCK_SIZE << index;
+    };
+
+    char*
+    heap_block
+    (size_t const size) {
+	return static_cast<char*>(::operator new(size));
+    };
+
+    void
+    free_heap_block
+    (char* block) noexcept {
+	::operator delete(block);
+    };
+
+    class Depot {
+    public:
+	Depot() {
+	    // reserve the full depot so returning blocks never allocates
+	    for (auto& blocks : _blocks) {
+		blocks.reserve(MAX_DEPOT_BLOCKS);
+	    };
+	};
+
+	// moves up to max blocks of a class onto the front of list
+	size_t take(size_t const index, FreeBlock*& list, size_t const max) {
+	    std::scoped_lock<std::mutex> lock(_lock);
+	    auto& blocks = _blocks[index];
+	    size_t taken = 0;
+	    while (taken < max && !blocks.empty()) {
+		FreeBlock* block = blocks.back();
+		blocks.pop_back();
+		block->_next = list;
+		list = block;
+		++taken;
+	    };
+	    return taken;
+	};
+
+	// takes up to count blocks off the front of list
+	void give(size_t const index, FreeBlock*& list, size_t const count) {
+	    std::scoped_lock<std::mutex> lock(_lock);
+	    auto& blocks = _blocks[index];
+	    for (size_t i = 0; i < count && list; ++i) {
+		FreeBlock* block = list;
+		list = block->_next;
+		if (blocks.size() < MAX_DEPOT_BLOCKS) {
+		    blocks.push_back(block);
+		} else {
+		    free_heap_block(reinterpret_cast<char*>(block));
+		};
+	    };
+	};
+    private:
+	std::mutex _lock;
+	std::vector<FreeBlock*> _blocks[SIZE_CLASSES];
+    };
+
+    Depot&
+    depot
+    () {
+	// deliberately never destroyed: detached threads may still release
+	// blocks while static destructors run
+	static Depot* shared = new Depot();
+	return *shared;
+    };
+
+    // trivially destructible, so still readable after the thread's other
+    // thread_locals, and the cache, have been destroyed
+    thread_local bool _cache_destroyed { false };
+
+    struct ThreadCache {
+	FreeBlock* _lists[SIZE_CLASSES] {};
+	size_t _counts[SIZE_CLASSES] {};
+
+	~ThreadCache() {
+	    for (size_t i = 0; i < SIZE_CLASSES; ++i) {
+		depot().give(i, _lists[i], _counts[i]);
+		_counts[i] = 0;
+	    };
+	    _cache_destroyed = true;
+	};
+    };
+
+    // nullptr once the thread's cache is gone, e.g. for a Message freed
+    // by a static destructor after main's thread_locals
+    ThreadCache*
+    thread_cache
+    () noexcept {
+	if (_cache_destroyed) {
+	    return nullptr;
+	};
+	thread_local ThreadCache cache;
+	return &cache;
+    };
+};
+
+char*
+ConsoleWriter::MessagePool::allocate
+(size_t& capacity) {
+    if (capacity > MAX_BLOCK_SIZE) {
+	return heap_block(capacity);
+    };
+    const size_t index = size_class(capacity);
+    capacity = class_size(index);
+    ThreadCache* cache = thread_cache();
+    if (!cache) {
+	FreeBlock* block = nullptr;
+	if (depot().take(index, block, 1) == 0) {
+	    return heap_block(capacity);
+	};
+	return reinterpret_cast<char*>(block);
+    };
+    FreeBlock*& list = cache->_lists[index];
+    if (!list) {
+	cache->_counts[index] += depot().take(index, list, BATCH_SIZE);
+    };
+    if (!list) {
+	return heap_block(capacity);
+    };
+    FreeBlock* block = list;
+    list = block->_next;
+    --cache->_counts[index];
+    return reinterpret_cast<char*>(block);
+};
+
+void
+ConsoleWriter::MessagePool::release
+(char* block, size_t const capacity) noexcept {
+    if (!block) {
+	return;
+    };
+    if (capacity > MAX_BLOCK_SIZE) {
+	free_heap_block(block);
+	return;
+    };
+    const size_t index = size_class(capacity);
+    FreeBlock* free_block = reinterpret_cast<FreeBlock*>(block);
+    ThreadCache* cache = thread_cache();
+    if (!cache) {
+	// straight to the depot, which is never destroyed
+	free_block->_next = nullptr;
+	depot().give(index, free_block, 1);
+	return;
+    };
+    free_block->_next = cache->_lists[index];
+    cache->_lists[index] = free_block;
+    if (++cache->_counts[index] > MAX_CACHED_PER_THREAD) {
+	depot().give(index, cache->_lists[index], BATCH_SIZE);
+	cache->_counts[index] -= BATCH_SIZE;
+    };
+};
@@ -0,0 +1,25 @@
+#ifndef CLASS_MESSAGE_POOL
+#define CLASS_MESSAGE_POOL
+
+#include <cstddef>
+
+namespace ConsoleWriter {
+    // Size-classed block pool backing Message text.
+    //
+    // Every thread keeps its own free list per size class, so a producer
+    // formatting a message normally allocates without touching shared
+    // state. Blocks freed on another thread (the console thread recycling
+    // rendered or overwritten history) collect in that thread's cache and
+    // spill back to a shared depot in batches, where producers refill from.
+    // Requests above the largest class go straight to the heap.
+    namespace MessagePool {
+	static constexpr size_t MIN_BLOCK_SIZE { 64 };
+	static constexpr size_t MAX_BLOCK_SIZE { 4096 };
+
+	// rounds capacity up to the block actually handed out
+	char* allocate(size_t& capacity);
+	void release(char* block, size_t const capacity) noexcept;
+    };
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string_view>
+
+namespace {
+    std::atomic<size_t> _next_stripe { 0 };
+
+    size_t
+    stripe_index
+    () noexcept {
+	thread_local const size_t index =
+	    _next_stripe.fetch_add(1, std::memory_order_relaxed);
+	return index;
+    };
+};
+
+void
+ConsoleWriter::Counter::add
+(uint64_t const count) noexcept {
+    _stripes[stripe_index() % STRIPES]._value.fetch_add
+	(count, std::memory_order_relaxed);
+};
+
+uint64_t
+ConsoleWriter::Counter::value
+() const noexcept {
+    uint64_t total = 0;
+    for (auto const& stripe : _stripes) {
+	total += stripe._value.load(std::memory_order_relaxed);
+    };
+    return total;
+};
+
+size_t
+ConsoleWriter::Histogram::bucket_of
+(uint64_t const value) noexcept {
+    if (value < SUB_BUCKETS) {
+	return static_cast<size_t>(value);
+    };
+    const size_t exponent = 63 - static_cast<size_t>(__builtin_clzll(value));
+    const size_t sub = static_cast<size_t>(value >> (exponent - 3))
+	& (SUB_BUCKETS - 1);
+    return (exponent - 2) * SUB_BUCKETS + sub;
+};
+
+uint64_t
+ConsoleWriter::Histogram::bucket_floor
+(size_t const bucket) noexcept {
+    if (bucket < SUB_BUCKETS) {
+	return bucket;
+    };
+    const size_t exponent = bucket / SUB_BUCKETS + 2;
+    return (SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 3);
+};
+
+uint64_t
+ConsoleWriter::Histogram::bucket_width
+(size_t const bucket) noexcept {
+    if (bucket < SUB_BUCKETS) {
+	return 1;
+    };
+    return uint64_t(1) << (bucket / SUB_BUCKETS - 1);
+};
+
+void
+ConsoleWriter::Histogram::record
+(uint64_t const value) noexcept {
+    _buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+    // only contended until the extremes settle
+    uint64_t low = _min.load(std::memory_order_relaxed);
+    while (value < low &&
+	   !_min.compare_exchange_weak(low, value,
+				       std::memory_order_relaxed)) {
+    };
+    uint64_t high = _max.load(std::memory_order_relaxed);
+    while (value > high &&
+	   !_max.compare_exchange_weak(high, value,
+				       std::memory_order_relaxed)) {
+    };
+};
+
+ConsoleWriter::Histogram::Snapshot
+ConsoleWriter::Histogram::snapshot
+() const {
+    Snapshot snapshot;
+    snapshot._buckets.resize(BUCKETS);
+    for (size_t i = 0; i < BUCKETS; ++i) {
+	snapshot._buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+	snapshot._count += snapshot._buckets[i];
+    };
+    // the bucket total, so quantiles agree with count even while
+    // records are landing
+    snapshot._sum = _sum.load(std::memory_order_relaxed);
+    snapshot._min = snapshot._count == 0 ? 0 :
+	_min.load(std::memory_order_relaxed);
+    snapshot._max = _max.load(std::memory_order_relaxed);
+    return snapshot;
+};
+
+double
+ConsoleWriter::Histogram::Snapshot::mean
+() const noexcept {
+    return _count == 0 ? 0.0 :
+	static_cast<double>(_sum) / static_cast<double>(_count);
+};
+
+double
+ConsoleWriter::Histogram::Snapshot::quantile
+(double const q) const noexcept {
+    if (_count == 0) {
+	return 0.0;
+    };
+    const double rank = std::max(0.0, std::min(1.0, q))
+	* static_cast<double>(_count - 1);
+    double seen = 0.0;
+    for (size_t i = 0; i < _buckets.size(); ++i) {
+	const double in_bucket = static_cast<double>(_buckets[i]);
+	if (in_bucket == 0.0 || seen + in_bucket <= rank) {
+	    seen += in_bucket;
+	    continue;
+	};
+	// the extremes narrow the first and last buckets
+	const double low = std::max(static_cast<double>(bucket_floor(i)),
+				    static_cast<double>(_min));
+	const double high = std::min(static_cast<double>(bucket_floor(i) +
+							 bucket_width(i)),
+				     static_cast<double>(_max) + 1.0);
+	const double within = (rank - seen + 0.5) / in_bucket;
+	return std::min(low + within * (high - low),
+			static_cast<double>(_max));
+    };
+    return static_cast<double>(_max);
+};
+
+Numerical::Statistics<double>
+ConsoleWriter::Histogram::Snapshot::statistics
+() const noexcept {
+    Numerical::Statistics<double> stats {};
+    if (_count == 0) {
+	return stats;
+    };
+    stats._min = static_cast<double>(_min);
+    stats._max = static_cast<double>(_max);
+    stats._mean = mean();
+    stats._median = quantile(0.5);
+    double squares = 0.0;
+    for (size_t i = 0; i < _buckets.size(); ++i) {
+	if (_buckets[i] == 0) {
+	    continue;
+	};
+	const double midpoint = static_cast<double>(bucket_floor(i)) +
+	    static_cast<double>(bucket_width(i) - 1) / 2.0;
+	const double offset = midpoint - stats._mean;
+	squares += static_cast<double>(_buckets[i]) * offset * offset;
+    };
+    stats._std_dev = _count > 1 ?
+	std::sqrt(squares / static_cast<double>(_count - 1)) : 0.0;
+    return stats;
+};
+
+void
+ConsoleWriter::Histogram::Snapshot::write_json
+(std::ostream& out, double const scale) const {
+    const auto stats = statistics();
+    out << "{\"count\":" << _count
+	<< ",\"min\":" << stats._min / scale
+	<< ",\"mean\":" << stats._mean / scale
+	<< ",\"std_dev\":" << stats._std_dev / scale
+	<< ",\"p50\":" << stats._median / scale
+	<< ",\"p90\":" << quantile(0.9) / scale
+	<< ",\"p99\":" << quantile(0.99) / scale
+	<< ",\"max\":" << stats._max / scale << "}";
+};
+
+void
+ConsoleWriter::write_json_string
+(std::ostream& out, std::string_view s) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    out << '"';
+    for (const char c : s) {
+	switch (c) {
+	case '"':
+	    out << "\\\"";
+	    break;
+	case '\\':
+	    out << "\\\\";
+	    break;
+	case '\n':
+	    out << "\\n";
+	    break;
+	case '\t':
+	    out << "\\t";
+	    break;
+	default:
+	    if (static_cast<unsigned char>(c) < 0x20) {
+		out << "\\u00" << HEX[(c >> 4) & 0xf] << HEX[c & 0xf];
+	    } else {
+		out << c;
+	    };
+	};
+    };
+    out << '"';
+};
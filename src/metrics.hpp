@@ -0,0 +1,80 @@
+#ifndef CLASS_METRICS
+#define CLASS_METRICS
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "numerical.hpp"
+
+namespace ConsoleWriter {
+    // Lock-free counter for hot paths written from many threads.
+    //
+    // Each thread adds to one of STRIPES cache-line sized slots, so
+    // producers do not bounce a single line between cores; value() adds
+    // the stripes up and may miss adds still in flight.
+    class Counter {
+    public:
+	void add(uint64_t const count = 1) noexcept;
+	uint64_t value() const noexcept;
+    private:
+	static constexpr size_t STRIPES { 16 };
+
+	struct alignas(64) Stripe {
+	    std::atomic<uint64_t> _value { 0 };
+	};
+
+	std::array<Stripe, STRIPES> _stripes;
+    };
+
+    // Lock-free histogram of non-negative integers (nanoseconds, counts).
+    //
+    // Log-linear buckets: values below 8 are exact, and every power of
+    // two above is split into 8, so a value is off by at most 12.5% of
+    // itself. Recording is a bucket increment plus sum/min/max updates,
+    // all relaxed; memory is fixed however many values arrive.
+    class Histogram {
+    public:
+	static constexpr size_t SUB_BUCKETS { 8 };
+	static constexpr size_t BUCKETS { 62 * SUB_BUCKETS };
+
+	struct Snapshot {
+	    uint64_t _count { 0 };
+	    uint64_t _sum { 0 };
+	    uint64_t _min { 0 };
+	    uint64_t _max { 0 };
+	    std::vector<uint64_t> _buckets;
+
+	    double mean() const noexcept;
+	    // interpolated within the bucket, clamped to min/max
+	    double quantile(double const q) const noexcept;
+	    // median from the buckets, std dev from their midpoints
+	    Numerical::Statistics<double> statistics() const noexcept;
+	    // {"count":..,"min":..,"mean":..,"p50":..,"p90":..,"p99":..,
+	    // "max":..}, each value divided by scale
+	    void write_json(std::ostream& out, double const scale) const;
+	};
+
+	void record(uint64_t const value) noexcept;
+	Snapshot snapshot() const;
+
+	static size_t bucket_of(uint64_t const value) noexcept;
+	static uint64_t bucket_floor(size_t const bucket) noexcept;
+	static uint64_t bucket_width(size_t const bucket) noexcept;
+    private:
+	std::array<std::atomic<uint64_t>, BUCKETS> _buckets {};
+	std::atomic<uint64_t> _count { 0 };
+	std::atomic<uint64_t> _sum { 0 };
+	std::atomic<uint64_t> _min { UINT64_MAX };
+	std::atomic<uint64_t> _max { 0 };
+    };
+
+    // writes s as a quoted JSON string
+    void write_json_string(std::ostream& out, std::string_view s);
+};
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef CLASS_MPSC_QUEUE
+#define CLASS_MPSC_QUEUE
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+
+namespace ConsoleWriter {
+    static constexpr size_t CACHE_LINE_SIZE { 64 };
+
+    // Bounded lock-free multi-producer, single-consumer queue.
+    //
+    // Each cell carries a sequence number (Vyukov's bounded queue). A
+    // producer claims a cell with one CAS on the enqueue position and
+    // publishes it by bumping the cell's sequence. The consumer claims a
+    // whole batch of ready cells with one CAS on the dequeue position,
+    // which lets a producer evict the oldest entry with try_pop when it
+    // would rather drop old messages than wait.
+    template <typename T>
+    class MpscQueue {
+    public:
+	explicit MpscQueue(size_t const capacity);
+	~MpscQueue();
+
+	MpscQueue(MpscQueue const& other) = delete;
+	MpscQueue &operator=(MpscQueue const& other) = delete;
+
+	bool try_push(T&& value) noexcept;
+	void push(T&& value) noexcept;
+
+	// safe from any thread, alongside the consumer
+	bool try_pop(T& out) noexcept;
+	template <typename Consumer>
+	size_t pop_batch(Consumer&& consumer,
+			 size_t const max_items = SIZE_MAX) noexcept;
+
+	size_t capacity() const noexcept { return _mask + 1; }
+	// counts cells claimed by a producer but not yet published
+	size_t size_approx() const noexcept;
+	// false only once the next cell to pop is published, the test
+	// try_pop makes, so a consumer waking on it finds something to pop
+	bool empty() const noexcept;
+    private:
+	struct Cell {
+	    std::atomic<size_t> _sequence;
+	    alignas(T) unsigned char _storage[sizeof(T)];
+
+	    T* value() noexcept {
+		return std::launder(reinterpret_cast<T*>(_storage));
+	    }
+	};
+
+	static size_t round_capacity(size_t const capacity) noexcept;
+
+	size_t const _mask;
+	std::unique_ptr<Cell[]> _cells;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> _enqueue_pos { 0 };
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> _dequeue_pos { 0 };
+    };
+};
+
+template <typename T>
+size_t
+ConsoleWriter::MpscQueue<T>::round_capacity
+(size_t const capacity) noexcept {
+    size_t rounded = 2;
+    while (rounded < capacity) {
+	rounded <<= 1;
+    };
+    return rounded;
+};
+
+template <typename T>
+ConsoleWriter::MpscQueue<T>::MpscQueue
+(size_t const capacity)
+    : _mask(round_capacity(capacity) - 1)
+    , _cells(std::make_unique<Cell[]>(_mask + 1)) {
+    for (size_t i = 0; i <= _mask; ++i) {
+	_cells[i]._sequence.store(i, std::memory_order_relaxed);
+    };
+};
+
+template <typename T>
+bool
+ConsoleWriter::MpscQueue<T>::empty
+() const noexcept {
+    const size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+    return _cells[pos & _mask]._sequence.load(std::memory_order_acquire) !=
+	pos + 1;
+};
+
+template <typename T>
+ConsoleWriter::MpscQueue<T>::~MpscQueue
+() {
+    pop_batch([] (T&&) { });
+};
+
+template <typename T>
+bool
+ConsoleWriter::MpscQueue<T>::try_push
+(T&& value) noexcept {
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    while (true) {
+	Cell& cell = _cells[pos & _mask];
+	const size_t seq = cell._sequence.load(std::memory_order_acquire);
+	const intptr_t diff = static_cast<intptr_t>(seq) -
+	    static_cast<intptr_t>(pos);
+	if (diff == 0) {
+	    if (_enqueue_pos.compare_exchange_weak
+		(pos, pos + 1, std::memory_order_relaxed)) {
+		new (cell._storage) T(std::move(value));
+		cell._sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	    };
+	} else if (diff < 0) {
+	    // the consumer has not yet released this cell: queue is full
+	    return false;
+	} else {
+	    pos = _enqueue_pos.load(std::memory_order_relaxed);
+	};
+    };
+};
+
+template <typename T>
+void
+ConsoleWriter::MpscQueue<T>::push
+(T&& value) noexcept {
+    while (!try_push(std::move(value))) {
+	std::this_thread::yield();
+    };
+};
+
+template <typename T>
+bool
+ConsoleWriter::MpscQueue<T>::try_pop
+(T& out) noexcept {
+    size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+    while (true) {
+	Cell& cell = _cells[pos & _mask];
+	const size_t seq = cell._sequence.load(std::memory_order_acquire);
+	if (seq != pos + 1) {
+	    return false;
+	};
+	if (_dequeue_pos.compare_exchange_weak
+	    (pos, pos + 1, std::memory_order_relaxed)) {
+	    T* value = cell.value();
+	    out = std::move(*value);
+	    value->~T();
+	    cell._sequence.store(pos + _mask + 1, std::memory_order_release);
+	    return true;
+	};
+    };
+};
+
+template <typename T>
+template <typename Consumer>
+size_t
+ConsoleWriter::MpscQueue<T>::pop_batch
+(Consumer&& consumer, size_t const max_items) noexcept {
+    size_t pos = _dequeue_pos.load(std::memory_order_relaxed);
+    size_t count = 0;
+    do {
+	count = 0;
+	while (count < max_items &&
+	       _cells[(pos + count) & _mask]._sequence.load
+	       (std::memory_order_acquire) == pos + count + 1) {
+	    ++count;
+	};
+	if (count == 0) {
+	    return 0;
+	};
+	// a failed claim means an eviction took the oldest cell: rescan
+    } while (!_dequeue_pos.compare_exchange_weak
+	     (pos, pos + count, std::memory_order_relaxed));
+    for (size_t i = 0; i < count; ++i) {
+	Cell& cell = _cells[(pos + i) & _mask];
+	T* value = cell.value();
+	consumer(std::move(*value));
+	value->~T();
+	cell._sequence.store(pos + i + _mask + 1, std::memory_order_release);
+    };
+    return count;
+};
+
+template <typename T>
+size_t
+ConsoleWriter::MpscQueue<T>::size_approx
+() const noexcept {
+    const size_t tail = _dequeue_pos.load(std::memory_order_relaxed);
+    const size_t head = _enqueue_pos.load(std::memory_order_relaxed);
+    return head > tail ? head - tail : 0;
+};
+
+#endif
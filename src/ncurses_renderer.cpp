@@ -0,0 +1,277 @@
+#include "ncurses_renderer.hpp"
+
+#include <algorithm>
+#include <ncurses.h>
+#include <poll.h>
+#include <unistd.h>
+
+ConsoleWriter::NcursesRenderer::NcursesRenderer
+() {
+    initscr();
+    curs_set(0);
+    start_color();
+    init_pair(Message::HIGHLIGHT, COLOR_BLACK, COLOR_WHITE);
+    init_pair(Message::NORMAL, COLOR_WHITE, COLOR_BLACK);
+    init_pair(Message::INPUT, COLOR_MAGENTA, COLOR_BLACK);
+    init_pair(Message::TIMESTAMP, COLOR_CYAN, COLOR_BLACK);
+    init_pair(Message::ERROR, COLOR_RED, COLOR_BLACK);
+    noecho();
+
+    _columns = COLS;
+    _area_rows = LINES > 2 ? LINES - 2 : 1;
+    layout(1);
+    _separator_window = newwin(1, _columns, _area_rows, 0);
+    _input_window = newwin(1, _columns, _area_rows + 1, 0);
+
+    keypad(_input_window, TRUE);
+    nodelay(_input_window, TRUE);
+
+    draw_separator(std::string());
+    draw_input_cell(0, ' ', true);
+    present();
+};
+
+ConsoleWriter::NcursesRenderer::~NcursesRenderer
+() {
+    layout(0);
+    delwin(_input_window);
+    delwin(_separator_window);
+    endwin();
+};
+
+void
+ConsoleWriter::NcursesRenderer::layout
+(size_t const count) noexcept {
+    for (auto& pane : _panes) {
+	if (pane._title) {
+	    delwin(pane._title);
+	};
+	delwin(pane._log);
+    };
+    if (_status_window) {
+	delwin(_status_window);
+	_status_window = nullptr;
+    };
+    if (count == 0) {
+	_panes.clear();
+	return;
+    };
+    const auto rows = split_rows(_area_rows - _status_rows, count);
+    _panes.assign(rows.size(), Pane());
+    int top = 0;
+    for (size_t i = 0; i < rows.size(); ++i) {
+	Pane& pane = _panes[i];
+	if (rows.size() > 1) {
+	    pane._title = newwin(1, _columns, top++, 0);
+	    pane._title_dirty = true;
+	};
+	pane._rows = rows[i];
+	pane._log = newwin(pane._rows, _columns, top, 0);
+	top += pane._rows;
+	// let curses use the terminal's own scrolling for the log region
+	scrollok(pane._log, TRUE);
+	idlok(pane._log, TRUE);
+	wsetscrreg(pane._log, 0, pane._rows - 1);
+	pane._log_dirty = true;
+    };
+    if (_status_rows > 0) {
+	_status_window = newwin(_status_rows, _columns, top, 0);
+	_status_dirty = true;
+    };
+};
+
+size_t
+ConsoleWriter::NcursesRenderer::max_panes
+() const noexcept {
+    return split_rows(_area_rows - _status_rows,
+		      static_cast<size_t>(_area_rows)).size();
+};
+
+void
+ConsoleWriter::NcursesRenderer::set_panes
+(size_t const count) noexcept {
+    layout(count);
+};
+
+void
+ConsoleWriter::NcursesRenderer::draw_pane_title
+(size_t const pane, std::string const& title) noexcept {
+    if (pane >= _panes.size() || !_panes[pane]._title) {
+	return;
+    };
+    WINDOW* window = _panes[pane]._title;
+    wattron(window, COLOR_PAIR(Message::HIGHLIGHT));
+    mvwhline(window, 0, 0, ' ', _columns);
+    mvwaddnstr(window, 0, 1, title.c_str(), _columns - 2);
+    wattroff(window, COLOR_PAIR(Message::HIGHLIGHT));
+    _panes[pane]._title_dirty = true;
+};
+
+int
+ConsoleWriter::NcursesRenderer::log_rows
+(size_t const pane) const noexcept {
+    return pane < _panes.size() ? _panes[pane]._rows : 1;
+};
+
+void
+ConsoleWriter::NcursesRenderer::append_line
+(size_t const index, Message const& message) noexcept {
+    if (index >= _panes.size()) {
+	return;
+    };
+    Pane& pane = _panes[index];
+    int row = pane._next_row;
+    if (row >= pane._rows) {
+	wscrl(pane._log, 1);
+	row = pane._rows - 1;
+    } else {
+	++pane._next_row;
+    };
+    draw_message(pane._log, row, message);
+    pane._log_dirty = true;
+};
+
+void
+ConsoleWriter::NcursesRenderer::draw_log_page
+(size_t const index, RingBuffer<Message> const& history,
+ size_t const end) noexcept {
+    if (index >= _panes.size()) {
+	return;
+    };
+    Pane& pane = _panes[index];
+    const size_t rows = static_cast<size_t>(pane._rows);
+    const size_t last = end < history.size() ? end : history.size();
+    const size_t first = last > rows ? last - rows : 0;
+    werase(pane._log);
+    for (size_t i = first; i < last; ++i) {
+	draw_message(pane._log, static_cast<int>(i - first), history[i]);
+    };
+    pane._next_row = static_cast<int>(last - first);
+    pane._log_dirty = true;
+};
+
+void
+ConsoleWriter::NcursesRenderer::set_status_rows
+(size_t const rows) noexcept {
+    // the log always keeps a row
+    const int status = std::min(static_cast<int>(rows), _area_rows - 1);
+    if (status == _status_rows) {
+	return;
+    };
+    _status_rows = status;
+    layout(_panes.size());
+};
+
+void
+ConsoleWriter::NcursesRenderer::draw_status_row
+(size_t const row, std::string const& text) noexcept {
+    if (!_status_window || row >= static_cast<size_t>(_status_rows)) {
+	return;
+    };
+    const int y = static_cast<int>(row);
+    wmove(_status_window, y, 0);
+    wclrtoeol(_status_window);
+    // not a scrolling window, so the last column is safe
+    mvwaddnstr(_status_window, y, 0, text.c_str(), _columns);
+    _status_dirty = true;
+};
+
+void
+ConsoleWriter::NcursesRenderer::draw_input_cell
+(size_t const column, char const character, bool const is_cursor) noexcept {
+    if (is_cursor) {
+	wattron(_input_window, COLOR_PAIR(Message::HIGHLIGHT));
+	mvwaddch(_input_window, 0, column, character);
+	wattroff(_input_window, COLOR_PAIR(Message::HIGHLIGHT));
+    } else {
+	mvwaddch(_input_window, 0, column, character);
+    };
+    _input_dirty = true;
+};
+
+void
+ConsoleWriter::NcursesRenderer::present
+() noexcept {
+    bool dirty = _status_dirty || _separator_dirty || _input_dirty;
+    for (auto& pane : _panes) {
+	if (pane._title_dirty) {
+	    wnoutrefresh(pane._title);
+	};
+	if (pane._log_dirty) {
+	    wnoutrefresh(pane._log);
+	};
+	dirty = dirty || pane._title_dirty || pane._log_dirty;
+	pane._title_dirty = pane._log_dirty = false;
+    };
+    if (!dirty) {
+	return;
+    };
+    if (_status_dirty && _status_window) {
+	wnoutrefresh(_status_window);
+    };
+    if (_separator_dirty) {
+	wnoutrefresh(_separator_window);
+    };
+    if (_input_dirty) {
+	wnoutrefresh(_input_window);
+    };
+    doupdate();
+    _status_dirty = _separator_dirty = _input_dirty = false;
+};
+
+bool
+ConsoleWriter::NcursesRenderer::wait_for_key
+(int const timeout_ms) noexcept {
+    // wait outside curses so the console thread can keep drawing
+    pollfd stdin_fd { STDIN_FILENO, POLLIN, 0 };
+    return poll(&stdin_fd, 1, timeout_ms) > 0;
+};
+
+int
+ConsoleWriter::NcursesRenderer::read_key
+() noexcept {
+    const int key = wgetch(_input_window);
+    return key == ERR ? NO_KEY : key;
+};
+
+void
+ConsoleWriter::NcursesRenderer::draw_message
+(WINDOW* window, int const row, Message const& message) noexcept {
+    // stop short of the last column: writing there in a scrolling window
+    // wraps the cursor and scrolls the whole region
+    const int width = _columns - 1;
+    int index = 0;
+    wmove(window, row, 0);
+    wclrtoeol(window);
+    if (message.has_timestamp()) {
+	char stamp[Timestamp::MAX_WIDTH];
+	const int length = static_cast<int>
+	    (Timestamp::format(message._enqueued, true, stamp));
+	wattron(window, COLOR_PAIR(Message::TIMESTAMP));
+	mvwaddnstr(window, row, 0, stamp, std::min(length, width));
+	wattroff(window, COLOR_PAIR(Message::TIMESTAMP));
+	index = length + 1;
+    };
+    for (size_t i = 0; i < message.chunk_count(); ++i) {
+	if (index >= width) {
+	    break;
+	};
+	const Message::Chunk chunk = message.chunk(i);
+	const int length = static_cast<int>(chunk._text.size());
+	wattron(window, COLOR_PAIR(chunk._colour));
+	mvwaddnstr(window, row, index, chunk._text.data(),
+		   std::min(length, width - index));
+	wattroff(window, COLOR_PAIR(chunk._colour));
+	index += length + 1;
+    };
+};
+
+void
+ConsoleWriter::NcursesRenderer::draw_separator
+(std::string const& label) noexcept {
+    mvwhline(_separator_window, 0, 0, '-', _columns);
+    if (!label.empty()) {
+	mvwaddnstr(_separator_window, 0, 2, label.c_str(), _columns - 4);
+    };
+    _separator_dirty = true;
+};
@@ -0,0 +1,80 @@
+#ifndef CLASS_NCURSES_RENDERER
+#define CLASS_NCURSES_RENDERER
+
+#include <vector>
+
+#include "renderer.hpp"
+
+typedef struct _win_st WINDOW;
+
+namespace ConsoleWriter {
+    // Owns the curses screen and stages each frame into separate windows
+    // (a title and a log per pane, status rows, separator, input line).
+    // Drawing only touches window buffers; present() pushes the dirty
+    // ones with wnoutrefresh and writes the terminal once with a single
+    // doupdate, so a busy pane never redraws a quiet one. Each log window
+    // has its own scroll region, so a new line at the bottom scrolls the
+    // terminal instead of redrawing every visible row.
+    class NcursesRenderer final : public Renderer {
+    public:
+	NcursesRenderer();
+	~NcursesRenderer();
+
+	NcursesRenderer(NcursesRenderer const& other) = delete;
+	NcursesRenderer &operator=(NcursesRenderer const& other) = delete;
+
+	size_t max_panes() const noexcept override;
+	void set_panes(size_t const count) noexcept override;
+	void draw_pane_title(size_t const pane,
+			     std::string const& title) noexcept override;
+
+	int log_rows(size_t const pane) const noexcept override;
+	int columns() const noexcept override { return _columns; }
+
+	void append_line(size_t const pane,
+			 Message const& message) noexcept override;
+	void draw_log_page(size_t const pane,
+			   RingBuffer<Message> const& history,
+			   size_t const end) noexcept override;
+	void draw_separator(std::string const& label) noexcept override;
+	void set_status_rows(size_t const rows) noexcept override;
+	void draw_status_row(size_t const row,
+			     std::string const& text) noexcept override;
+	void draw_input_cell(size_t const column, char const character,
+			     bool const is_cursor) noexcept override;
+	void present() noexcept override;
+
+	bool accepts_input() const noexcept override { return true; }
+	bool wait_for_key(int const timeout_ms) noexcept override;
+	int read_key() noexcept override;
+    private:
+	struct Pane {
+	    // only when there is more than one pane
+	    WINDOW* _title { nullptr };
+	    WINDOW* _log { nullptr };
+	    int _rows { 0 };
+	    int _next_row { 0 };
+	    bool _title_dirty { false };
+	    bool _log_dirty { false };
+	};
+
+	// rebuilds the pane and status windows; their contents are lost
+	void layout(size_t const count) noexcept;
+	void draw_message(WINDOW* window, int const row,
+			  Message const& message) noexcept;
+
+	std::vector<Pane> _panes;
+	WINDOW* _status_window { nullptr };
+	WINDOW* _separator_window { nullptr };
+	WINDOW* _input_window { nullptr };
+	// rows above the separator, shared by the panes and status rows
+	int _area_rows { 0 };
+	int _status_rows { 0 };
+	int _columns { 0 };
+	bool _status_dirty { false };
+	bool _separator_dirty { false };
+	bool _input_dirty { false };
+    };
+};
+
+#endif
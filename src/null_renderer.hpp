@@ -0,0 +1,45 @@
+#ifndef CLASS_NULL_RENDERER
+#define CLASS_NULL_RENDERER
+
+#include <atomic>
+
+#include "renderer.hpp"
+
+namespace ConsoleWriter {
+    // Discards everything, so benchmarks measure the pipeline up to the
+    // point of drawing. Counts what it was given.
+    class NullRenderer final : public Renderer {
+    public:
+	explicit NullRenderer(int const rows = 24, int const columns = 80)
+	    : _rows(rows), _columns(columns) {}
+
+	int log_rows(size_t const) const noexcept override { return _rows; }
+	int columns() const noexcept override { return _columns; }
+
+	void append_line(size_t const, Message const&) noexcept override {
+	    _lines.fetch_add(1, std::memory_order_relaxed);
+	}
+	void draw_log_page(size_t const, RingBuffer<Message> const&,
+			   size_t const) noexcept override {}
+	void draw_separator(std::string const&) noexcept override {}
+	void draw_input_cell(size_t const, char const,
+			     bool const) noexcept override {}
+	void present() noexcept override {
+	    _frames.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	size_t lines() const noexcept {
+	    return _lines.load(std::memory_order_relaxed);
+	}
+	size_t frames() const noexcept {
+	    return _frames.load(std::memory_order_relaxed);
+	}
+    private:
+	int const _rows;
+	int const _columns;
+	std::atomic<size_t> _lines { 0 };
+	std::atomic<size_t> _frames { 0 };
+    };
+};
+
+#endif
@@ -4,22 +4,13 @@
 #include <cstdint>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include <numeric>
 #include <cmath>
 
-namespace Numerical {
-    static uint64_t unique_rand_uint () {
-	static std::vector<uint64_t> drawn_values;
-	while (true) {
-	    uint64_t val = 0;
-	    if (std::find(drawn_values.cbegin(),
-			 drawn_values.cend(),
-			 val) == drawn_values.cend())
-		drawn_values.push_back(val);
-	    return val;
-	};
-    };
+#include "numerical_kernels.hpp"
 
+namespace Numerical {
     template <typename T>
     struct Statistics {
 	T _min;
@@ -33,30 +24,39 @@ namespace Numerical {
     static T
     average_mean
     (std::vector<T> const& values) {
-	T total = std::accumulate(values.begin(),
-				  values.end(),
-				  static_cast<T>(0));
-	return total / static_cast<T>(values.size());
+	return static_cast<T>(
+	    Kernels::moments(values.data(), values.size())._mean);
     };
 
     template <typename T>
     static T
     average_median
     (std::vector<T> const& values, Statistics<T>* stats = nullptr) {
+	if (values.empty()) {
+	    if (stats) {
+		stats->_min = T {};
+		stats->_max = T {};
+	    };
+	    return T {};
+	};
 	std::vector<T> copy = values;
-	std::sort(copy.begin(), copy.end());
 
 	if (stats) {
-	    stats->_min = values.front();
-	    stats->_max = values.back();
+	    const auto [min, max] = std::minmax_element(copy.begin(),
+							copy.end());
+	    stats->_min = *min;
+	    stats->_max = *max;
 	};
-	
+
+	// selection rather than a full sort; the lower middle of an even
+	// count is the largest value left below the upper one
+	const size_t i = copy.size() / 2;
+	std::nth_element(copy.begin(), copy.begin() + i, copy.end());
 	if (copy.size() % 2 == 0) {
-	    const size_t i = copy.size() / 2;
-	    const size_t j = i - 1;
-	    return (copy[i] + copy[j]) / static_cast<T>(2);
+	    const T lower = *std::max_element(copy.begin(), copy.begin() + i);
+	    return (copy[i] + lower) / static_cast<T>(2);
 	} else {
-	    return copy[static_cast<size_t>(std::floor(copy.size() / 2.0))];
+	    return copy[i];
 	};
     };
 
@@ -64,22 +64,340 @@ namespace Numerical {
     static T
     average_std_dev
     (std::vector<T> const& values, T const mean) {
-	T var = 0;
-	for (const auto& val : values) {
-	    var += pow((val - mean), 2);
-	};
-	var *= (1.0 / (values.size() - 1) );
-	return static_cast<T>(pow(var, 0.5));
+	// sum((x - mean)^2) = m2 + n (true mean - mean)^2
+	const auto moments = Kernels::moments(values.data(), values.size());
+	const double n = static_cast<double>(moments._count);
+	const double offset = moments._mean - static_cast<double>(mean);
+	const double var = (moments._m2 + n * offset * offset) / (n - 1.0);
+	return static_cast<T>(std::sqrt(var));
     };
     
+    // Count, mean, variance and exact min/max in O(1) memory (Welford).
+    // Not thread safe: give each thread its own and merge() them.
+    template <typename T>
+    class RunningStatistics {
+    public:
+	RunningStatistics() = default;
+	// from a bulk pass over an array, see Kernels::moments
+	explicit RunningStatistics(Kernels::Moments<T> const& moments)
+	    : _moments(moments) {
+	};
+
+	void
+	add
+	(T const value) noexcept {
+	    auto& m = _moments;
+	    const double x = static_cast<double>(value);
+	    if (m._count == 0) {
+		m._min = value;
+		m._max = value;
+	    } else {
+		m._min = std::min(m._min, value);
+		m._max = std::max(m._max, value);
+	    };
+	    ++m._count;
+	    const double delta = x - m._mean;
+	    m._mean += delta / static_cast<double>(m._count);
+	    m._m2 += delta * (x - m._mean);
+	};
+
+	void
+	merge
+	(RunningStatistics const& other) noexcept {
+	    _moments = Kernels::merge(_moments, other._moments);
+	};
+
+	void reset() noexcept { _moments = Kernels::Moments<T>(); }
+
+	uint64_t count() const noexcept { return _moments._count; }
+	double mean() const noexcept { return _moments._mean; }
+	T min() const noexcept { return _moments._min; }
+	T max() const noexcept { return _moments._max; }
+	// sample variance, as average_std_dev
+	double
+	variance
+	() const noexcept {
+	    return _moments._count > 1 ?
+		_moments._m2 / static_cast<double>(_moments._count - 1) : 0.0;
+	};
+	double std_dev() const noexcept { return std::sqrt(variance()); }
+    private:
+	Kernels::Moments<T> _moments;
+    };
+
+    // Approximate quantiles in memory bounded by the compression, not the
+    // number of samples (Dunning's merging t-digest, k2 scale). Centroids
+    // shrink towards single samples at the tails, so p99/p999 stay
+    // accurate where the median is allowed to be coarser. Not thread
+    // safe: merge() per-thread digests instead.
+    class TDigest {
+    public:
+	explicit TDigest(double const compression = 200.0)
+	    : _compression(std::max(compression, 10.0)) {
+	    _buffer.reserve(buffer_capacity());
+	};
+
+	void
+	add
+	(double const value, double const weight = 1.0) {
+	    if (std::isnan(value) || weight <= 0.0) {
+		return;
+	    };
+	    if (_weight == 0.0) {
+		_min = value;
+		_max = value;
+	    } else {
+		_min = std::min(_min, value);
+		_max = std::max(_max, value);
+	    };
+	    _weight += weight;
+	    _buffer.push_back(Centroid { value, weight });
+	    if (_buffer.size() >= buffer_capacity()) {
+		compress();
+	    };
+	};
+
+	void
+	merge
+	(TDigest const& other) {
+	    if (other._weight == 0.0) {
+		return;
+	    };
+	    if (_weight == 0.0) {
+		_min = other._min;
+		_max = other._max;
+	    } else {
+		_min = std::min(_min, other._min);
+		_max = std::max(_max, other._max);
+	    };
+	    _weight += other._weight;
+	    _buffer.insert(_buffer.end(), other._centroids.begin(),
+			   other._centroids.end());
+	    _buffer.insert(_buffer.end(), other._buffer.begin(),
+			   other._buffer.end());
+	    compress();
+	};
+
+	void
+	reset
+	() noexcept {
+	    _centroids.clear();
+	    _buffer.clear();
+	    _weight = 0.0;
+	};
+
+	double count() const noexcept { return _weight; }
+	double min() const noexcept { return _min; }
+	double max() const noexcept { return _max; }
+	size_t
+	centroids
+	() const {
+	    compress();
+	    return _centroids.size();
+	};
+
+	// q in [0, 1]; NaN when empty
+	double
+	quantile
+	(double const q) const {
+	    if (_weight == 0.0) {
+		return std::numeric_limits<double>::quiet_NaN();
+	    };
+	    compress();
+	    if (q <= 0.0) {
+		return _min;
+	    };
+	    if (q >= 1.0) {
+		return _max;
+	    };
+	    const double index = q * _weight;
+	    Centroid const& first = _centroids.front();
+	    Centroid const& last = _centroids.back();
+	    // half of each centroid's weight lies either side of its mean;
+	    // the tails interpolate out to the exact extremes
+	    if (index < first._weight / 2.0) {
+		return interpolate(_min, first._mean,
+				   index / (first._weight / 2.0));
+	    };
+	    double seen = first._weight / 2.0;
+	    for (size_t i = 0; i + 1 < _centroids.size(); ++i) {
+		Centroid const& left = _centroids[i];
+		Centroid const& right = _centroids[i + 1];
+		const double step = (left._weight + right._weight) / 2.0;
+		if (seen + step > index) {
+		    return interpolate(left._mean, right._mean,
+				       (index - seen) / step);
+		};
+		seen += step;
+	    };
+	    const double tail = last._weight / 2.0;
+	    return interpolate(last._mean, _max,
+			       std::min(1.0, (index - seen) / tail));
+	};
+    private:
+	struct Centroid {
+	    double _mean;
+	    double _weight;
+	};
+
+	size_t
+	buffer_capacity
+	() const noexcept {
+	    return static_cast<size_t>(_compression) * 5;
+	};
+
+	static double
+	interpolate
+	(double const a, double const b, double const t) noexcept {
+	    return a + (b - a) * t;
+	};
+
+	// k2(q) = compression / z * log(q / (1 - q)), with z growing
+	// slowly with the sample count so the centroid count stays near
+	// the compression
+	double
+	normaliser
+	() const noexcept {
+	    return _compression
+		/ (4.0 * std::log(std::max(_weight / _compression, 1.0))
+		   + 24.0);
+	};
+
+	static double
+	scale
+	(double const q, double const norm) noexcept {
+	    if (q <= 0.0) {
+		return -std::numeric_limits<double>::infinity();
+	    };
+	    if (q >= 1.0) {
+		return std::numeric_limits<double>::infinity();
+	    };
+	    return norm * std::log(q / (1.0 - q));
+	};
+
+	static double
+	inverse_scale
+	(double const k, double const norm) noexcept {
+	    return 1.0 / (1.0 + std::exp(-k / norm));
+	};
+
+	// folds the buffer into the centroids; each merged centroid spans
+	// at most one unit of k, so the count stays near the compression
+	void
+	compress
+	() const {
+	    if (_buffer.empty()) {
+		return;
+	    };
+	    _buffer.insert(_buffer.end(), _centroids.begin(),
+			   _centroids.end());
+	    std::sort(_buffer.begin(), _buffer.end(),
+		      [] (Centroid const& a, Centroid const& b) {
+			  return a._mean < b._mean;
+		      });
+	    _centroids.clear();
+	    const double norm = normaliser();
+	    Centroid current = _buffer.front();
+	    double seen = 0.0;
+	    double limit = _weight * inverse_scale(scale(0.0, norm) + 1.0,
+						   norm);
+	    for (size_t i = 1; i < _buffer.size(); ++i) {
+		Centroid const& next = _buffer[i];
+		if (seen + current._weight + next._weight <= limit) {
+		    current._weight += next._weight;
+		    current._mean += (next._mean - current._mean)
+			* next._weight / current._weight;
+		} else {
+		    seen += current._weight;
+		    _centroids.push_back(current);
+		    limit = _weight
+			* inverse_scale(scale(seen / _weight, norm) + 1.0,
+					norm);
+		    current = next;
+		};
+	    };
+	    _centroids.push_back(current);
+	    _buffer.clear();
+	};
+
+	double _compression;
+	double _weight { 0.0 };
+	double _min { 0.0 };
+	double _max { 0.0 };
+	// compressed lazily, so the read-only queries may still fold the
+	// buffer in
+	mutable std::vector<Centroid> _centroids;
+	mutable std::vector<Centroid> _buffer;
+    };
+
+    // RunningStatistics plus a TDigest: everything get_stats reports, with
+    // an approximate median, over a stream of any length.
+    class StreamingStatistics {
+    public:
+	explicit StreamingStatistics(double const compression = 200.0)
+	    : _digest(compression) {
+	};
+
+	void
+	add
+	(double const value) {
+	    _moments.add(value);
+	    _digest.add(value);
+	};
+
+	void
+	merge
+	(StreamingStatistics const& other) {
+	    _moments.merge(other._moments);
+	    _digest.merge(other._digest);
+	};
+
+	void
+	reset
+	() noexcept {
+	    _moments.reset();
+	    _digest.reset();
+	};
+
+	uint64_t count() const noexcept { return _moments.count(); }
+	RunningStatistics<double> const& moments() const noexcept {
+	    return _moments;
+	}
+	double quantile(double const q) const { return _digest.quantile(q); }
+
+	Statistics<double>
+	statistics
+	() const {
+	    Statistics<double> stats;
+	    stats._min = _moments.min();
+	    stats._max = _moments.max();
+	    stats._mean = _moments.mean();
+	    stats._median = _digest.quantile(0.5);
+	    stats._std_dev = _moments.std_dev();
+	    return stats;
+	};
+    private:
+	RunningStatistics<double> _moments;
+	TDigest _digest;
+    };
+
+    // exact: one fused pass for the moments, one selection for the
+    // median. threads as Kernels::moments. All zero for no values
     template <typename T>
     static Statistics<T>
     get_stats
-    (std::vector<T> const& values) {
+    (std::vector<T> const& values, unsigned int const threads = 1) {
+	if (values.empty()) {
+	    return Statistics<T> {};
+	};
+	const RunningStatistics<T> running(
+	    Kernels::moments(values.data(), values.size(), threads));
 	Statistics<T> stats;
-	stats._mean = average_mean(values);
-	stats._median = average_median(values, &stats);
-	stats._std_dev = average_std_dev(values, stats._mean);
+	stats._min = running.min();
+	stats._max = running.max();
+	stats._mean = static_cast<T>(running.mean());
+	stats._median = average_median(values);
+	stats._std_dev = static_cast<T>(running.std_dev());
 	return stats;
     };
 };
@@ -0,0 +1,440 @@
+#ifndef NAMESPACE_NUMERICAL_KERNELS
+#define NAMESPACE_NUMERICAL_KERNELS
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace Numerical {
+    // Bulk kernels for the statistics of a whole array.
+    //
+    // One pass gives the count, sum, sum of squares, min and max. Sums are
+    // taken over x - shift, with shift the first element, so the squares
+    // stay small when the mean is far from zero and the variance does not
+    // cancel away. Accumulation is in double for every element type. The
+    // widest instruction set the CPU supports is picked at run time, and
+    // large arrays are split across threads whose partial moments are
+    // merged. NaNs are not supported.
+    namespace Kernels {
+	enum class InstructionSet {
+	    SCALAR,
+	    SSE2,
+	    AVX2
+	};
+
+	// arrays at least this long are split across threads by default
+	static constexpr size_t PARALLEL_THRESHOLD { size_t(1) << 22 };
+
+	template <typename T>
+	struct Moments {
+	    uint64_t _count { 0 };
+	    double _mean { 0.0 };
+	    // sum of squared differences from the mean
+	    double _m2 { 0.0 };
+	    T _min {};
+	    T _max {};
+	};
+
+	// Chan et al.'s pairwise update, exact up to rounding
+	template <typename T>
+	inline Moments<T>
+	merge
+	(Moments<T> const& a, Moments<T> const& b) noexcept {
+	    if (b._count == 0) {
+		return a;
+	    };
+	    if (a._count == 0) {
+		return b;
+	    };
+	    const double n_a = static_cast<double>(a._count);
+	    const double n_b = static_cast<double>(b._count);
+	    const double n = n_a + n_b;
+	    const double delta = b._mean - a._mean;
+	    Moments<T> merged;
+	    merged._count = a._count + b._count;
+	    merged._mean = a._mean + delta * n_b / n;
+	    merged._m2 = a._m2 + b._m2 + delta * delta * n_a * n_b / n;
+	    merged._min = std::min(a._min, b._min);
+	    merged._max = std::max(a._max, b._max);
+	    return merged;
+	};
+
+	inline char const*
+	to_string
+	(InstructionSet const set) noexcept {
+	    switch (set) {
+	    case InstructionSet::AVX2:
+		return "avx2";
+	    case InstructionSet::SSE2:
+		return "sse2";
+	    default:
+		return "scalar";
+	    };
+	};
+
+	inline InstructionSet
+	supported_instruction_set
+	() noexcept {
+#if defined(__x86_64__)
+	    __builtin_cpu_init();
+	    if (__builtin_cpu_supports("avx2")
+		&& __builtin_cpu_supports("fma")) {
+		return InstructionSet::AVX2;
+	    };
+	    return InstructionSet::SSE2;
+#else
+	    return InstructionSet::SCALAR;
+#endif
+	};
+
+	inline std::atomic<InstructionSet>&
+	selected_instruction_set
+	() noexcept {
+	    static std::atomic<InstructionSet> selected
+	    { supported_instruction_set() };
+	    return selected;
+	};
+
+	inline InstructionSet
+	instruction_set
+	() noexcept {
+	    return selected_instruction_set().load(std::memory_order_relaxed);
+	};
+
+	// for benchmarks; never goes past what the CPU supports
+	inline void
+	set_instruction_set
+	(InstructionSet const set) noexcept {
+	    selected_instruction_set().store(
+		std::min(set, supported_instruction_set()),
+		std::memory_order_relaxed);
+	};
+
+	template <typename T>
+	struct ShiftedSums {
+	    double _sum { 0.0 };
+	    double _sum_squares { 0.0 };
+	    T _min;
+	    T _max;
+	};
+
+	template <typename T>
+	inline Moments<T>
+	to_moments
+	(ShiftedSums<T> const& sums, size_t const count,
+	 double const shift) noexcept {
+	    Moments<T> moments;
+	    moments._count = count;
+	    const double n = static_cast<double>(count);
+	    moments._mean = shift + sums._sum / n;
+	    moments._m2 = std::max(0.0, sums._sum_squares
+				   - sums._sum * sums._sum / n);
+	    moments._min = sums._min;
+	    moments._max = sums._max;
+	    return moments;
+	};
+
+	// also finishes the tails the vector kernels leave behind
+	template <typename T>
+	inline void
+	sums_scalar
+	(T const* data, size_t const count, double const shift,
+	 ShiftedSums<T>& sums) noexcept {
+	    // four chains so the adds are not serialised on one register
+	    double s[4] = { 0.0, 0.0, 0.0, 0.0 };
+	    double q[4] = { 0.0, 0.0, 0.0, 0.0 };
+	    size_t i = 0;
+	    for (; i + 4 <= count; i += 4) {
+		for (size_t j = 0; j < 4; ++j) {
+		    const double x = static_cast<double>(data[i + j]) - shift;
+		    s[j] += x;
+		    q[j] += x * x;
+		    sums._min = std::min(sums._min, data[i + j]);
+		    sums._max = std::max(sums._max, data[i + j]);
+		};
+	    };
+	    for (; i < count; ++i) {
+		const double x = static_cast<double>(data[i]) - shift;
+		s[0] += x;
+		q[0] += x * x;
+		sums._min = std::min(sums._min, data[i]);
+		sums._max = std::max(sums._max, data[i]);
+	    };
+	    sums._sum += (s[0] + s[1]) + (s[2] + s[3]);
+	    sums._sum_squares += (q[0] + q[1]) + (q[2] + q[3]);
+	};
+
+#if defined(__x86_64__)
+	inline double
+	horizontal_sum
+	(__m128d const v) noexcept {
+	    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+	};
+
+	__attribute__((target("avx2")))
+	inline double
+	horizontal_sum
+	(__m256d const v) noexcept {
+	    return horizontal_sum(_mm_add_pd(_mm256_castpd256_pd128(v),
+					     _mm256_extractf128_pd(v, 1)));
+	};
+
+	// exact over the whole int64 range (Mysticial's magic-number split)
+	__attribute__((target("avx2")))
+	inline __m256d
+	int64_to_double
+	(__m256i const x) noexcept {
+	    const __m256i magic_hi = _mm256_set1_epi64x(0x4530000080000000);
+	    const __m256i magic_all = _mm256_set1_epi64x(0x4530000080100000);
+	    const __m256i magic_lo = _mm256_set1_epi64x(0x4330000000000000);
+	    const __m256i lo = _mm256_blend_epi32(magic_lo, x, 0x55);
+	    const __m256i hi = _mm256_xor_si256(_mm256_srli_epi64(x, 32),
+						magic_hi);
+	    const __m256d hi_d = _mm256_sub_pd(_mm256_castsi256_pd(hi),
+					       _mm256_castsi256_pd(magic_all));
+	    return _mm256_add_pd(hi_d, _mm256_castsi256_pd(lo));
+	};
+
+	inline size_t
+	sums_sse2
+	(double const* data, size_t const count, double const shift,
+	 ShiftedSums<double>& sums) noexcept {
+	    const __m128d offset = _mm_set1_pd(shift);
+	    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+	    __m128d q0 = _mm_setzero_pd(), q1 = _mm_setzero_pd();
+	    __m128d lo = _mm_set1_pd(sums._min), hi = _mm_set1_pd(sums._max);
+	    size_t i = 0;
+	    for (; i + 4 <= count; i += 4) {
+		__m128d a = _mm_loadu_pd(data + i);
+		__m128d b = _mm_loadu_pd(data + i + 2);
+		lo = _mm_min_pd(lo, _mm_min_pd(a, b));
+		hi = _mm_max_pd(hi, _mm_max_pd(a, b));
+		a = _mm_sub_pd(a, offset);
+		b = _mm_sub_pd(b, offset);
+		s0 = _mm_add_pd(s0, a);
+		s1 = _mm_add_pd(s1, b);
+		q0 = _mm_add_pd(q0, _mm_mul_pd(a, a));
+		q1 = _mm_add_pd(q1, _mm_mul_pd(b, b));
+	    };
+	    double l[2], h[2];
+	    _mm_storeu_pd(l, lo);
+	    _mm_storeu_pd(h, hi);
+	    sums._min = std::min(l[0], l[1]);
+	    sums._max = std::max(h[0], h[1]);
+	    sums._sum += horizontal_sum(_mm_add_pd(s0, s1));
+	    sums._sum_squares += horizontal_sum(_mm_add_pd(q0, q1));
+	    return i;
+	};
+
+	inline size_t
+	sums_sse2
+	(float const* data, size_t const count, double const shift,
+	 ShiftedSums<float>& sums) noexcept {
+	    const __m128d offset = _mm_set1_pd(shift);
+	    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+	    __m128d q0 = _mm_setzero_pd(), q1 = _mm_setzero_pd();
+	    __m128 lo = _mm_set1_ps(sums._min), hi = _mm_set1_ps(sums._max);
+	    size_t i = 0;
+	    for (; i + 4 <= count; i += 4) {
+		const __m128 v = _mm_loadu_ps(data + i);
+		lo = _mm_min_ps(lo, v);
+		hi = _mm_max_ps(hi, v);
+		const __m128d a = _mm_sub_pd(_mm_cvtps_pd(v), offset);
+		const __m128d b = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)),
+					     offset);
+		s0 = _mm_add_pd(s0, a);
+		s1 = _mm_add_pd(s1, b);
+		q0 = _mm_add_pd(q0, _mm_mul_pd(a, a));
+		q1 = _mm_add_pd(q1, _mm_mul_pd(b, b));
+	    };
+	    float l[4], h[4];
+	    _mm_storeu_ps(l, lo);
+	    _mm_storeu_ps(h, hi);
+	    sums._min = *std::min_element(l, l + 4);
+	    sums._max = *std::max_element(h, h + 4);
+	    sums._sum += horizontal_sum(_mm_add_pd(s0, s1));
+	    sums._sum_squares += horizontal_sum(_mm_add_pd(q0, q1));
+	    return i;
+	};
+
+	__attribute__((target("avx2,fma")))
+	inline size_t
+	sums_avx2
+	(double const* data, size_t const count, double const shift,
+	 ShiftedSums<double>& sums) noexcept {
+	    const __m256d offset = _mm256_set1_pd(shift);
+	    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	    __m256d q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+	    __m256d lo = _mm256_set1_pd(sums._min);
+	    __m256d hi = _mm256_set1_pd(sums._max);
+	    size_t i = 0;
+	    for (; i + 8 <= count; i += 8) {
+		__m256d a = _mm256_loadu_pd(data + i);
+		__m256d b = _mm256_loadu_pd(data + i + 4);
+		lo = _mm256_min_pd(lo, _mm256_min_pd(a, b));
+		hi = _mm256_max_pd(hi, _mm256_max_pd(a, b));
+		a = _mm256_sub_pd(a, offset);
+		b = _mm256_sub_pd(b, offset);
+		s0 = _mm256_add_pd(s0, a);
+		s1 = _mm256_add_pd(s1, b);
+		q0 = _mm256_fmadd_pd(a, a, q0);
+		q1 = _mm256_fmadd_pd(b, b, q1);
+	    };
+	    double l[4], h[4];
+	    _mm256_storeu_pd(l, lo);
+	    _mm256_storeu_pd(h, hi);
+	    sums._min = *std::min_element(l, l + 4);
+	    sums._max = *std::max_element(h, h + 4);
+	    sums._sum += horizontal_sum(_mm256_add_pd(s0, s1));
+	    sums._sum_squares += horizontal_sum(_mm256_add_pd(q0, q1));
+	    return i;
+	};
+
+	__attribute__((target("avx2,fma")))
+	inline size_t
+	sums_avx2
+	(float const* data, size_t const count, double const shift,
+	 ShiftedSums<float>& sums) noexcept {
+	    const __m256d offset = _mm256_set1_pd(shift);
+	    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	    __m256d q0 = _mm256_setzero_pd(), q1 = _mm256_setzero_pd();
+	    __m256 lo = _mm256_set1_ps(sums._min);
+	    __m256 hi = _mm256_set1_ps(sums._max);
+	    size_t i = 0;
+	    for (; i + 8 <= count; i += 8) {
+		const __m256 v = _mm256_loadu_ps(data + i);
+		lo = _mm256_min_ps(lo, v);
+		hi = _mm256_max_ps(hi, v);
+		const __m256d a =
+		    _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)),
+				  offset);
+		const __m256d b =
+		    _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)),
+				  offset);
+		s0 = _mm256_add_pd(s0, a);
+		s1 = _mm256_add_pd(s1, b);
+		q0 = _mm256_fmadd_pd(a, a, q0);
+		q1 = _mm256_fmadd_pd(b, b, q1);
+	    };
+	    float l[8], h[8];
+	    _mm256_storeu_ps(l, lo);
+	    _mm256_storeu_ps(h, hi);
+	    sums._min = *std::min_element(l, l + 8);
+	    sums._max = *std::max_element(h, h + 8);
+	    sums._sum += horizontal_sum(_mm256_add_pd(s0, s1));
+	    sums._sum_squares += horizontal_sum(_mm256_add_pd(q0, q1));
+	    return i;
+	};
+
+	__attribute__((target("avx2,fma")))
+	inline size_t
+	sums_avx2
+	(int64_t const* data, size_t const count, double const shift,
+	 ShiftedSums<int64_t>& sums) noexcept {
+	    const __m256d offset = _mm256_set1_pd(shift);
+	    __m256d s0 = _mm256_setzero_pd(), q0 = _mm256_setzero_pd();
+	    __m256i lo = _mm256_set1_epi64x(sums._min);
+	    __m256i hi = _mm256_set1_epi64x(sums._max);
+	    size_t i = 0;
+	    for (; i + 4 <= count; i += 4) {
+		const __m256i v = _mm256_loadu_si256(
+		    reinterpret_cast<__m256i const*>(data + i));
+		lo = _mm256_blendv_epi8(lo, v, _mm256_cmpgt_epi64(lo, v));
+		hi = _mm256_blendv_epi8(hi, v, _mm256_cmpgt_epi64(v, hi));
+		const __m256d a = _mm256_sub_pd(int64_to_double(v), offset);
+		s0 = _mm256_add_pd(s0, a);
+		q0 = _mm256_fmadd_pd(a, a, q0);
+	    };
+	    alignas(32) int64_t l[4], h[4];
+	    _mm256_store_si256(reinterpret_cast<__m256i*>(l), lo);
+	    _mm256_store_si256(reinterpret_cast<__m256i*>(h), hi);
+	    sums._min = *std::min_element(l, l + 4);
+	    sums._max = *std::max_element(h, h + 4);
+	    sums._sum += horizontal_sum(s0);
+	    sums._sum_squares += horizontal_sum(q0);
+	    return i;
+	};
+#endif
+
+	template <typename T>
+	inline Moments<T>
+	moments_serial
+	(T const* data, size_t const count,
+	 InstructionSet const set = instruction_set()) noexcept {
+	    if (count == 0) {
+		return Moments<T>();
+	    };
+	    const double shift = static_cast<double>(data[0]);
+	    ShiftedSums<T> sums;
+	    sums._min = data[0];
+	    sums._max = data[0];
+	    size_t done = 0;
+#if defined(__x86_64__)
+	    constexpr bool vectorised = std::is_same_v<T, double>
+		|| std::is_same_v<T, float> || std::is_same_v<T, int64_t>;
+	    if constexpr (vectorised) {
+		if (set == InstructionSet::AVX2) {
+		    done = sums_avx2(data, count, shift, sums);
+		} else if constexpr (!std::is_same_v<T, int64_t>) {
+		    // SSE2 has no 64-bit compare, so int64 stays scalar
+		    if (set == InstructionSet::SSE2) {
+			done = sums_sse2(data, count, shift, sums);
+		    };
+		};
+	    };
+#endif
+	    sums_scalar(data + done, count - done, shift, sums);
+	    return to_moments(sums, count, shift);
+	};
+
+	// single threaded unless the caller asks for more; threads == 0
+	// picks one per core once count reaches PARALLEL_THRESHOLD
+	template <typename T>
+	inline Moments<T>
+	moments
+	(T const* data, size_t const count, unsigned int threads = 1) {
+	    if (threads == 0) {
+		threads = count < PARALLEL_THRESHOLD ? 1 :
+		    std::max(1u, std::thread::hardware_concurrency());
+	    };
+	    // no thread gets less than a quarter of the threshold
+	    threads = static_cast<unsigned int>(
+		std::min<size_t>(threads, std::max<size_t>(
+				     1, count / (PARALLEL_THRESHOLD / 4))));
+	    const InstructionSet set = instruction_set();
+	    if (threads <= 1) {
+		return moments_serial(data, count, set);
+	    };
+	    std::vector<Moments<T>> parts(threads);
+	    std::vector<std::thread> workers;
+	    workers.reserve(threads - 1);
+	    const size_t chunk = count / threads;
+	    for (unsigned int t = 1; t < threads; ++t) {
+		const size_t begin = t * chunk;
+		const size_t end = t + 1 == threads ? count : begin + chunk;
+		workers.emplace_back([=, &parts] () {
+		    parts[t] = moments_serial(data + begin, end - begin, set);
+		});
+	    };
+	    parts[0] = moments_serial(data, chunk, set);
+	    for (auto& worker : workers) {
+		worker.join();
+	    };
+	    Moments<T> total;
+	    for (auto const& part : parts) {
+		total = merge(total, part);
+	    };
+	    return total;
+	};
+    };
+};
+
+#endif
@@ -0,0 +1,290 @@
+#include "process_executor.hpp"
+
+#include <algorithm>
+
+namespace {
+    // the worker the calling thread is, if any, and the task it is running
+    struct CurrentWorker {
+	ProcessExecutor const* _executor { nullptr };
+	size_t _index { 0 };
+	ProcessExecutor::Task const* _task { nullptr };
+    };
+
+    thread_local CurrentWorker _current;
+};
+
+ProcessExecutor::Task::Task
+(ProcessExecutor& executor, Step&& step)
+    : _executor(executor)
+    , _step(std::move(step)) {
+};
+
+void
+ProcessExecutor::Task::wake
+() noexcept {
+    uint8_t state = _state.load();
+    while (true) {
+	if (state == QUEUED || state == RUNNING_WOKEN) {
+	    return;
+	};
+	const uint8_t next = state == IDLE ? QUEUED : RUNNING_WOKEN;
+	if (_state.compare_exchange_weak(state, next)) {
+	    if (next == QUEUED) {
+		_executor.push(shared_from_this(), false);
+	    };
+	    return;
+	};
+    };
+};
+
+void
+ProcessExecutor::Task::wake_at
+(Clock::time_point const deadline) {
+    // an earlier pending deadline covers this one: the step it runs can
+    // set the next timer itself
+    const Clock::rep stamp = deadline.time_since_epoch().count();
+    Clock::rep pending = _timer.load();
+    while (stamp < pending) {
+	if (_timer.compare_exchange_weak(pending, stamp)) {
+	    _executor.add_timer(deadline, weak_from_this());
+	    return;
+	};
+    };
+};
+
+void
+ProcessExecutor::Task::detach
+() noexcept {
+    // pairs with run(): either it sees the flag, or this sees it running
+    _detached.store(true);
+    if (_current._task == this) {
+	return;
+    };
+    while (true) {
+	const uint8_t state = _state.load();
+	if (state != RUNNING && state != RUNNING_WOKEN) {
+	    return;
+	};
+	std::this_thread::yield();
+    };
+};
+
+void
+ProcessExecutor::Task::run
+() noexcept {
+    _state.store(RUNNING);
+    if (_detached.load()) {
+	_state.store(IDLE);
+	return;
+    };
+    _current._task = this;
+    const bool again = _step();
+    _current._task = nullptr;
+    if (again) {
+	_state.store(QUEUED);
+	_executor.push(shared_from_this(), true);
+	return;
+    };
+    uint8_t state = RUNNING;
+    if (!_state.compare_exchange_strong(state, IDLE)) {
+	// woken while running
+	_state.store(QUEUED);
+	_executor.push(shared_from_this(), false);
+    };
+};
+
+ProcessExecutor::ProcessExecutor
+(size_t threads) {
+    if (threads == 0) {
+	threads = std::max(1u, std::thread::hardware_concurrency());
+    };
+    _workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+	_workers.push_back(std::make_unique<Worker>());
+    };
+    for (size_t i = 0; i < threads; ++i) {
+	_workers[i]->_thread = std::thread([this, i] () { run_worker(i); });
+    };
+};
+
+ProcessExecutor::~ProcessExecutor
+() {
+    {
+	std::scoped_lock<std::mutex> lock(_park_lock);
+	_stopping = true;
+    }
+    _park_cv.notify_all();
+    for (auto& worker : _workers) {
+	worker->_thread.join();
+    };
+};
+
+ProcessExecutor&
+ProcessExecutor::shared
+() {
+    static ProcessExecutor* executor = new ProcessExecutor();
+    return *executor;
+};
+
+std::shared_ptr<ProcessExecutor::Task>
+ProcessExecutor::make_task
+(Task::Step&& step) {
+    return std::make_shared<Task>(*this, std::move(step));
+};
+
+ProcessExecutor::Stats
+ProcessExecutor::stats
+() const noexcept {
+    Stats stats { _workers.size(), 0, 0, _parks.load(),
+		  _timers_fired.load() };
+    for (auto const& worker : _workers) {
+	stats._runs += worker->_runs.load(std::memory_order_relaxed);
+	stats._steals += worker->_steals.load(std::memory_order_relaxed);
+    };
+    return stats;
+};
+
+void
+ProcessExecutor::push
+(std::shared_ptr<Task>&& task, bool const yield) {
+    // a worker keeps what it wakes; anyone else spreads the load
+    const size_t index = _current._executor == this ? _current._index :
+	_next_worker.fetch_add(1, std::memory_order_relaxed)
+	% _workers.size();
+    Worker& worker = *_workers[index];
+    {
+	std::scoped_lock<std::mutex> lock(worker._lock);
+	if (yield) {
+	    worker._queue.push_front(std::move(task));
+	} else {
+	    worker._queue.push_back(std::move(task));
+	};
+    }
+    // pairs with park(): either the sleeper sees the count, or this sees
+    // the sleeper
+    _pending.fetch_add(1);
+    if (_sleepers.load() > 0) {
+	std::scoped_lock<std::mutex> lock(_park_lock);
+	_park_cv.notify_one();
+    };
+};
+
+void
+ProcessExecutor::add_timer
+(Clock::time_point const deadline, std::weak_ptr<Task>&& task) {
+    bool earliest = false;
+    {
+	std::scoped_lock<std::mutex> lock(_timer_lock);
+	earliest = _timers.empty() || deadline < _timers.top()._deadline;
+	_timers.push(Timer { deadline, std::move(task) });
+	if (earliest) {
+	    _next_deadline.store(deadline.time_since_epoch().count());
+	};
+    }
+    if (earliest) {
+	std::scoped_lock<std::mutex> lock(_park_lock);
+	_timer_generation.fetch_add(1);
+	_park_cv.notify_one();
+    };
+};
+
+bool
+ProcessExecutor::fire_timers
+() {
+    std::vector<Timer> due;
+    {
+	std::scoped_lock<std::mutex> lock(_timer_lock);
+	const auto now = Clock::now();
+	while (!_timers.empty() && _timers.top()._deadline <= now) {
+	    due.push_back(_timers.top());
+	    _timers.pop();
+	};
+	_next_deadline.store((_timers.empty() ? Clock::time_point::max() :
+			      _timers.top()._deadline)
+			     .time_since_epoch().count());
+    }
+    for (auto& timer : due) {
+	if (auto task = timer._task.lock()) {
+	    Clock::rep stamp = timer._deadline.time_since_epoch().count();
+	    task->_timer.compare_exchange_strong(
+		stamp, Clock::time_point::max().time_since_epoch().count());
+	    task->wake();
+	};
+    };
+    _timers_fired.fetch_add(due.size(), std::memory_order_relaxed);
+    return !due.empty();
+};
+
+std::shared_ptr<ProcessExecutor::Task>
+ProcessExecutor::take
+(size_t const index) {
+    std::shared_ptr<Task> task;
+    {
+	Worker& own = *_workers[index];
+	std::scoped_lock<std::mutex> lock(own._lock);
+	if (!own._queue.empty()) {
+	    task = std::move(own._queue.back());
+	    own._queue.pop_back();
+	};
+    }
+    for (size_t i = 1; !task && i < _workers.size(); ++i) {
+	Worker& victim = *_workers[(index + i) % _workers.size()];
+	std::scoped_lock<std::mutex> lock(victim._lock);
+	if (!victim._queue.empty()) {
+	    task = std::move(victim._queue.front());
+	    victim._queue.pop_front();
+	    _workers[index]->_steals.fetch_add(1, std::memory_order_relaxed);
+	};
+    };
+    if (task) {
+	_pending.fetch_sub(1);
+    };
+    return task;
+};
+
+void
+ProcessExecutor::park
+() {
+    std::unique_lock<std::mutex> lock(_park_lock);
+    // read before the deadline: a timer added after this bumps it
+    const uint64_t generation = _timer_generation.load();
+    const Clock::time_point deadline { Clock::duration(
+	    _next_deadline.load()) };
+    _sleepers.fetch_add(1);
+    auto ready = [&] () {
+	return _pending.load() > 0 || _stopping.load() ||
+	    _timer_generation.load() != generation;
+    };
+    if (!ready()) {
+	_parks.fetch_add(1, std::memory_order_relaxed);
+	if (deadline == Clock::time_point::max()) {
+	    _park_cv.wait(lock, ready);
+	} else {
+	    _park_cv.wait_until(lock, deadline, ready);
+	};
+    };
+    _sleepers.fetch_sub(1);
+};
+
+void
+ProcessExecutor::run_worker
+(size_t const index) {
+    _current._executor = this;
+    _current._index = index;
+    while (!_stopping.load(std::memory_order_acquire)) {
+	if (auto task = take(index)) {
+	    _workers[index]->_runs.fetch_add(1, std::memory_order_relaxed);
+	    task->run();
+	    // a busy pool must still fire its timers
+	    if (Clock::now().time_since_epoch().count()
+		>= _next_deadline.load(std::memory_order_relaxed)) {
+		fire_timers();
+	    };
+	    continue;
+	};
+	if (fire_timers()) {
+	    continue;
+	};
+	park();
+    };
+};
@@ -0,0 +1,141 @@
+#ifndef CLASS_PROCESS_EXECUTOR
+#define CLASS_PROCESS_EXECUTOR
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool that runs cooperative ThreadedProcesses.
+//
+// A process is a Task: a step function called on some worker whenever the
+// process is woken. Each worker has its own run queue; a worker takes from
+// the back of its own (the task it queued last is the one still in cache)
+// and, once that is empty, steals from the front of the others'. Idle
+// workers park on a condition variable and also fire the timers set with
+// Task::wake_at, so one pool sized to the core count can carry thousands
+// of mostly idle processes.
+class ProcessExecutor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    class Task : public std::enable_shared_from_this<Task> {
+    public:
+	// returns true to be run again once the other queued tasks have
+	// had a turn
+	using Step = std::function<bool()>;
+
+	Task(ProcessExecutor& executor, Step&& step);
+
+	Task(Task const& other) = delete;
+	Task &operator=(Task const& other) = delete;
+
+	// queues the task unless it already is; a wake while it runs
+	// makes it run again straight after
+	void wake() noexcept;
+	// coalesced with any earlier deadline still pending
+	void wake_at(Clock::time_point const deadline);
+	// once this returns no step is running and none will start; safe
+	// to call from inside the task's own step
+	void detach() noexcept;
+    private:
+	friend class ProcessExecutor;
+
+	enum State : uint8_t {
+	    IDLE,
+	    QUEUED,
+	    RUNNING,
+	    RUNNING_WOKEN
+	};
+
+	void run() noexcept;
+
+	ProcessExecutor& _executor;
+	Step _step;
+	std::atomic<uint8_t> _state { IDLE };
+	std::atomic<bool> _detached { false };
+	// the earliest timer pending for this task, max() if none
+	std::atomic<Clock::rep> _timer { Clock::time_point::max()
+	    .time_since_epoch().count() };
+    };
+
+    struct Stats {
+	size_t _threads;
+	uint64_t _runs;
+	uint64_t _steals;
+	uint64_t _parks;
+	uint64_t _timers_fired;
+    };
+
+    // 0 starts one worker per core
+    explicit ProcessExecutor(size_t threads = 0);
+    ~ProcessExecutor();
+
+    ProcessExecutor(ProcessExecutor const& other) = delete;
+    ProcessExecutor &operator=(ProcessExecutor const& other) = delete;
+
+    // the pool cooperative ThreadedProcesses use by default; never
+    // destroyed, so processes outliving main can still be woken
+    static ProcessExecutor& shared();
+
+    std::shared_ptr<Task> make_task(Task::Step&& step);
+    size_t threads() const noexcept { return _workers.size(); }
+    Stats stats() const noexcept;
+private:
+    struct Worker {
+	std::mutex _lock;
+	std::deque<std::shared_ptr<Task>> _queue;
+	std::atomic<uint64_t> _runs { 0 };
+	std::atomic<uint64_t> _steals { 0 };
+	std::thread _thread;
+    };
+
+    struct Timer {
+	Clock::time_point _deadline;
+	std::weak_ptr<Task> _task;
+
+	bool operator>(Timer const& other) const noexcept {
+	    return _deadline > other._deadline;
+	}
+    };
+
+    // a yield goes to the front, behind everything else the owner has
+    void push(std::shared_ptr<Task>&& task, bool const yield);
+    void add_timer(Clock::time_point const deadline,
+		   std::weak_ptr<Task>&& task);
+    bool fire_timers();
+    std::shared_ptr<Task> take(size_t const index);
+    void park();
+    void run_worker(size_t const index);
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::atomic<size_t> _next_worker { 0 };
+    std::atomic<size_t> _pending { 0 };
+    std::atomic<bool> _stopping { false };
+
+    // parked workers
+    std::mutex _park_lock;
+    std::condition_variable _park_cv;
+    std::atomic<size_t> _sleepers { 0 };
+    std::atomic<uint64_t> _parks { 0 };
+
+    std::mutex _timer_lock;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>>
+    _timers;
+    // bumped when a new earliest timer arrives so sleepers recompute
+    // their deadline
+    std::atomic<uint64_t> _timer_generation { 0 };
+    // lets busy workers see a timer is due without taking the lock
+    std::atomic<Clock::rep> _next_deadline { Clock::time_point::max()
+	.time_since_epoch().count() };
+    std::atomic<uint64_t> _timers_fired { 0 };
+};
+
+#endif
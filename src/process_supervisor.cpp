@@ -0,0 +1,215 @@
+#include "process_supervisor.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+ProcessSupervisor::ProcessSupervisor
+()
+    : _stopped_future(_stopped.get_future()) {
+};
+
+ProcessSupervisor::~ProcessSupervisor
+() {
+    if (_shutdown_thread.joinable()) {
+	_shutdown_thread.join();
+    };
+};
+
+void
+ProcessSupervisor::add
+(std::shared_ptr<ThreadedProcess> process) {
+    std::scoped_lock<std::mutex> lock(_lock);
+    const uint64_t id = process->get_unique_id();
+    _nodes[id]._process = std::move(process);
+};
+
+void
+ProcessSupervisor::add_dependency
+(ThreadedProcess const& dependent, ThreadedProcess const& dependency) {
+    std::scoped_lock<std::mutex> lock(_lock);
+    const uint64_t from = dependent.get_unique_id();
+    const uint64_t to = dependency.get_unique_id();
+    if (_nodes.count(from) == 0 || _nodes.count(to) == 0) {
+	throw std::invalid_argument("add_dependency: " +
+				    dependent.process_name() + " or " +
+				    dependency.process_name() +
+				    " was never added");
+    };
+    // the new edge closes a cycle if dependency already reaches dependent
+    std::vector<uint64_t> cycle { from };
+    if (from != to) {
+	const auto path = find_path(to, from);
+	if (path.empty()) {
+	    _nodes[from]._dependencies.insert(to);
+	    _nodes[to]._dependents.insert(from);
+	    return;
+	};
+	cycle.insert(cycle.end(), path.begin(), path.end());
+    } else {
+	cycle.push_back(to);
+    };
+    throw std::invalid_argument("dependency cycle: " + describe(cycle));
+};
+
+std::vector<uint64_t>
+ProcessSupervisor::find_path
+(uint64_t const from, uint64_t const to) const {
+    // depth-first, remembering how each process was reached
+    std::unordered_map<uint64_t, uint64_t> parent { { from, from } };
+    std::vector<uint64_t> stack { from };
+    while (!stack.empty()) {
+	const uint64_t id = stack.back();
+	stack.pop_back();
+	if (id == to) {
+	    std::vector<uint64_t> path { to };
+	    for (uint64_t at = to; at != from; ) {
+		at = parent[at];
+		path.push_back(at);
+	    };
+	    std::reverse(path.begin(), path.end());
+	    return path;
+	};
+	for (const uint64_t next : _nodes.at(id)._dependencies) {
+	    if (parent.emplace(next, id).second) {
+		stack.push_back(next);
+	    };
+	};
+    };
+    return {};
+};
+
+std::string
+ProcessSupervisor::describe
+(std::vector<uint64_t> const& path) const {
+    std::stringstream ss;
+    for (size_t i = 0; i < path.size(); ++i) {
+	if (i != 0) {
+	    ss << " -> ";
+	};
+	ss << _nodes.at(path[i])._process->process_name() << "#" << path[i];
+    };
+    return ss.str();
+};
+
+ProcessSupervisor::Levels
+ProcessSupervisor::levels
+(bool const reversed) const {
+    std::unordered_map<uint64_t, size_t> waiting;
+    std::vector<uint64_t> ready;
+    for (auto const& [id, node] : _nodes) {
+	const size_t count = reversed ? node._dependents.size() :
+	    node._dependencies.size();
+	waiting[id] = count;
+	if (count == 0) {
+	    ready.push_back(id);
+	};
+    };
+    Levels order;
+    size_t placed = 0;
+    while (!ready.empty()) {
+	std::sort(ready.begin(), ready.end());
+	std::vector<uint64_t> next;
+	for (const uint64_t id : ready) {
+	    auto const& node = _nodes.at(id);
+	    for (const uint64_t after : reversed ? node._dependencies :
+		     node._dependents) {
+		if (--waiting[after] == 0) {
+		    next.push_back(after);
+		};
+	    };
+	};
+	placed += ready.size();
+	order.push_back(std::move(ready));
+	ready = std::move(next);
+    };
+    if (placed != _nodes.size()) {
+	// add_dependency never lets one in
+	throw std::logic_error("dependency cycle in process supervisor");
+    };
+    return order;
+};
+
+ProcessSupervisor::Levels
+ProcessSupervisor::start_order
+() const {
+    std::scoped_lock<std::mutex> lock(_lock);
+    return levels(false);
+};
+
+ProcessSupervisor::Levels
+ProcessSupervisor::shutdown_order
+() const {
+    std::scoped_lock<std::mutex> lock(_lock);
+    return levels(true);
+};
+
+void
+ProcessSupervisor::start_all
+() {
+    std::vector<std::vector<std::shared_ptr<ThreadedProcess>>> order;
+    {
+	std::scoped_lock<std::mutex> lock(_lock);
+	for (auto const& level : levels(false)) {
+	    order.emplace_back();
+	    for (const uint64_t id : level) {
+		auto const& process = _nodes.at(id)._process;
+		if (!process->launched()) {
+		    order.back().push_back(process);
+		};
+	    };
+	};
+    }
+    for (auto const& level : order) {
+	if (level.size() == 1) {
+	    level.front()->launch();
+	    continue;
+	};
+	std::vector<std::future<void>> launches;
+	for (auto const& process : level) {
+	    launches.push_back(std::async(std::launch::async, [process] () {
+		process->launch();
+	    }));
+	};
+	// get() passes on anything start() threw
+	for (auto& launched : launches) {
+	    launched.get();
+	};
+    };
+};
+
+std::shared_future<void>
+ProcessSupervisor::shutdown_all
+() {
+    std::scoped_lock<std::mutex> lock(_lock);
+    if (!_shutdown_requested) {
+	_shutdown_requested = true;
+	_shutdown_thread = std::thread([this, order = levels(true)] () {
+	    run_shutdown(order);
+	});
+    };
+    return _stopped_future;
+};
+
+void
+ProcessSupervisor::run_shutdown
+(Levels const& order) {
+    for (auto const& level : order) {
+	std::vector<std::shared_ptr<ThreadedProcess>> processes;
+	{
+	    std::scoped_lock<std::mutex> lock(_lock);
+	    for (const uint64_t id : level) {
+		processes.push_back(_nodes.at(id)._process);
+	    };
+	}
+	// the whole level stops together
+	for (auto const& process : processes) {
+	    process->shutdown();
+	};
+	for (auto const& process : processes) {
+	    if (process->launched()) {
+		process->finished().wait();
+	    };
+	};
+    };
+    _stopped.set_value();
+};
@@ -0,0 +1,81 @@
+#ifndef CLASS_PROCESS_SUPERVISOR
+#define CLASS_PROCESS_SUPERVISOR
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "threaded_process.hpp"
+
+// Starts and stops a set of ThreadedProcesses in dependency order.
+//
+// add_dependency(dependent, dependency) means dependency is launched
+// before dependent and shut down after it. Edges that would close a cycle
+// are rejected when added. start_all() launches the graph level by level,
+// launching the processes of one level in parallel; shutdown_all() works
+// back the other way, shutting a process down once everything that
+// depends on it has finished, and reports completion through a future
+// rather than polling is_deletable().
+class ProcessSupervisor {
+public:
+    // processes that share a level have no path between them
+    using Levels = std::vector<std::vector<uint64_t>>;
+
+    ProcessSupervisor();
+    ~ProcessSupervisor();
+
+    ProcessSupervisor(ProcessSupervisor const& other) = delete;
+    ProcessSupervisor &operator=(ProcessSupervisor const& other) = delete;
+
+    // shares ownership so a process lives until the supervisor is done
+    // with it; already launched processes are fine
+    void add(std::shared_ptr<ThreadedProcess> process);
+    // both must have been added; throws std::invalid_argument naming the
+    // cycle, leaving the graph unchanged, if dependency already depends
+    // on dependent
+    void add_dependency(ThreadedProcess const& dependent,
+			ThreadedProcess const& dependency);
+
+    Levels start_order() const;
+    Levels shutdown_order() const;
+
+    // launches whatever has not been launched yet
+    void start_all();
+    // returns at once; the first call starts the shutdown on a thread of
+    // the supervisor's and later calls return the same future
+    std::shared_future<void> shutdown_all();
+    // ready once shutdown_all() has stopped every process
+    std::shared_future<void> stopped() const { return _stopped_future; }
+private:
+    struct Node {
+	std::shared_ptr<ThreadedProcess> _process;
+	// processes this one needs, and processes that need this one
+	std::unordered_set<uint64_t> _dependencies;
+	std::unordered_set<uint64_t> _dependents;
+    };
+
+    // Kahn's algorithm over _dependencies, or over _dependents when
+    // reversed
+    Levels levels(bool const reversed) const;
+    // a path from -> ... -> to along _dependencies, empty if none
+    std::vector<uint64_t> find_path(uint64_t const from,
+				    uint64_t const to) const;
+    std::string describe(std::vector<uint64_t> const& path) const;
+    void run_shutdown(Levels const& order);
+
+    mutable std::mutex _lock;
+    std::unordered_map<uint64_t, Node> _nodes;
+
+    bool _shutdown_requested { false };
+    std::thread _shutdown_thread;
+    std::promise<void> _stopped;
+    std::shared_future<void> _stopped_future;
+};
+
+#endif
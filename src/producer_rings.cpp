@@ -0,0 +1,81 @@
+#include "producer_rings.hpp"
+
+namespace {
+    using ConsoleWriter::ProducerRings;
+
+    std::atomic<uint64_t> _next_id { 1 };
+
+    // the calling thread's ring in whichever ProducerRings it last used
+    struct LocalRing {
+	uint64_t _owner { 0 };
+	std::shared_ptr<ProducerRings::Slot> _slot;
+
+	~LocalRing() {
+	    if (_slot) {
+		_slot->_closed.store(true, std::memory_order_release);
+	    };
+	}
+    };
+
+    thread_local LocalRing _local;
+};
+
+ConsoleWriter::ProducerRings::ProducerRings
+(size_t const ring_capacity)
+    : _id(_next_id.fetch_add(1, std::memory_order_relaxed))
+    , _ring_capacity(ring_capacity) {
+};
+
+ConsoleWriter::ProducerRings::Ring&
+ConsoleWriter::ProducerRings::local
+() {
+    if (_local._owner == _id) {
+	return _local._slot->_ring;
+    };
+    return register_thread();
+};
+
+ConsoleWriter::ProducerRings::Ring&
+ConsoleWriter::ProducerRings::register_thread
+() {
+    if (_local._slot) {
+	// the thread moved on from an older console
+	_local._slot->_closed.store(true, std::memory_order_release);
+    };
+    _local._slot = std::make_shared<Slot>(_ring_capacity);
+    _local._owner = _id;
+    {
+	std::scoped_lock<std::mutex> lock(_register_lock);
+	_registered.push_back(_local._slot);
+    }
+    _has_registered.store(true, std::memory_order_release);
+    return _local._slot->_ring;
+};
+
+void
+ConsoleWriter::ProducerRings::adopt_new_rings
+() {
+    if (!_has_registered.load(std::memory_order_acquire)) {
+	return;
+    };
+    std::scoped_lock<std::mutex> lock(_register_lock);
+    _has_registered.store(false, std::memory_order_relaxed);
+    for (auto& slot : _registered) {
+	_slots.push_back(std::move(slot));
+    };
+    _registered.clear();
+};
+
+bool
+ConsoleWriter::ProducerRings::empty
+() noexcept {
+    if (_has_registered.load(std::memory_order_acquire)) {
+	return false;
+    };
+    for (auto const& slot : _slots) {
+	if (slot->_ring.size_approx() > 0) {
+	    return false;
+	};
+    };
+    return true;
+};
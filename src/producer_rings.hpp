@@ -0,0 +1,123 @@
+#ifndef CLASS_PRODUCER_RINGS
+#define CLASS_PRODUCER_RINGS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "message.hpp"
+#include "spsc_ring.hpp"
+
+namespace ConsoleWriter {
+    // One SPSC ring of messages per producing thread, merged by the
+    // console thread in enqueue-time order.
+    //
+    // A thread's ring is registered the first time it calls local() and
+    // marked closed by a thread_local destructor when the thread exits;
+    // the console drops it once it has drained it. Registration is the
+    // only step that takes a lock, so producers share nothing in the
+    // steady state.
+    class ProducerRings {
+    public:
+	using Ring = SpscRing<Message>;
+
+	struct Slot {
+	    explicit Slot(size_t const capacity) : _ring(capacity) {}
+
+	    Ring _ring;
+	    std::atomic<bool> _closed { false };
+	};
+
+	explicit ProducerRings(size_t const ring_capacity);
+
+	ProducerRings(ProducerRings const& other) = delete;
+	ProducerRings &operator=(ProducerRings const& other) = delete;
+
+	// the calling thread's ring
+	Ring& local();
+
+	// consumer side, console thread only
+	bool empty() noexcept;
+	// hands over every message that was queued when the merge began,
+	// oldest enqueue time first
+	template <typename Consumer>
+	size_t merge(Consumer&& consumer);
+	size_t rings() const noexcept { return _slots.size(); }
+    private:
+	struct Head {
+	    Timestamp::Clock::time_point _enqueued;
+	    size_t _slot;
+
+	    // std::push_heap keeps the largest first
+	    bool operator<(Head const& other) const noexcept {
+		return _enqueued > other._enqueued;
+	    }
+	};
+
+	Ring& register_thread();
+	void adopt_new_rings();
+
+	uint64_t const _id;
+	size_t const _ring_capacity;
+
+	std::mutex _register_lock;
+	std::vector<std::shared_ptr<Slot>> _registered;
+	std::atomic<bool> _has_registered { false };
+
+	// owned by the console thread
+	std::vector<std::shared_ptr<Slot>> _slots;
+	std::vector<size_t> _remaining;
+	std::vector<Head> _heap;
+    };
+};
+
+template <typename Consumer>
+size_t
+ConsoleWriter::ProducerRings::merge
+(Consumer&& consumer) {
+    adopt_new_rings();
+    _heap.clear();
+    _remaining.assign(_slots.size(), 0);
+    for (size_t i = 0; i < _slots.size(); ++i) {
+	Ring& ring = _slots[i]->_ring;
+	// bound the merge so a busy thread cannot keep it going forever
+	_remaining[i] = ring.size_approx();
+	Message* front = _remaining[i] > 0 ? ring.front() : nullptr;
+	if (front) {
+	    _heap.push_back(Head { front->_enqueued, i });
+	};
+    };
+    std::make_heap(_heap.begin(), _heap.end());
+
+    size_t count = 0;
+    while (!_heap.empty()) {
+	std::pop_heap(_heap.begin(), _heap.end());
+	const size_t i = _heap.back()._slot;
+	_heap.pop_back();
+	Ring& ring = _slots[i]->_ring;
+	consumer(std::move(*ring.front()));
+	ring.pop();
+	++count;
+	Message* next = --_remaining[i] > 0 ? ring.front() : nullptr;
+	if (next) {
+	    _heap.push_back(Head { next->_enqueued, i });
+	    std::push_heap(_heap.begin(), _heap.end());
+	};
+    };
+
+    // forget threads that have exited once their ring is drained
+    for (size_t i = _slots.size(); i > 0; --i) {
+	Slot& slot = *_slots[i - 1];
+	if (slot._closed.load(std::memory_order_acquire) &&
+	    !slot._ring.front()) {
+	    _slots[i - 1] = std::move(_slots.back());
+	    _slots.pop_back();
+	};
+    };
+    return count;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "renderer.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string_view>
+#include <unistd.h>
+
+#include "ansi_renderer.hpp"
+#include "memory_renderer.hpp"
+#include "ncurses_renderer.hpp"
+#include "null_renderer.hpp"
+#include "timestamp.hpp"
+
+std::string
+ConsoleWriter::Renderer::plain_text
+(Message const& message) {
+    std::string line;
+    line.reserve(Timestamp::MAX_WIDTH + message.text_size() +
+		 message.chunk_count());
+    if (message.has_timestamp()) {
+	char stamp[Timestamp::MAX_WIDTH];
+	line.append(stamp, Timestamp::format(message._enqueued, true, stamp));
+    };
+    for (size_t i = 0; i < message.chunk_count(); ++i) {
+	if (!line.empty()) {
+	    line.push_back(' ');
+	};
+	line += message.chunk(i)._text;
+    };
+    return line;
+};
+
+std::vector<int>
+ConsoleWriter::Renderer::split_rows
+(int const area, size_t const count) {
+    size_t panes = std::max<size_t>(count, 1);
+    while (panes > 1 && static_cast<size_t>(area) < panes * 2) {
+	--panes;
+    };
+    if (panes == 1) {
+	return { std::max(area, 1) };
+    };
+    const int rows = area - static_cast<int>(panes);
+    const int each = rows / static_cast<int>(panes);
+    std::vector<int> split(panes, each);
+    // the last pane takes the rows that do not divide evenly
+    split.back() += rows % static_cast<int>(panes);
+    return split;
+};
+
+ConsoleWriter::RenderBackend
+ConsoleWriter::default_render_backend
+() noexcept {
+    char const* requested = std::getenv("FBCURSES_RENDERER");
+    if (requested) {
+	const std::string_view name(requested);
+	if (name == "ncurses") {
+	    return RenderBackend::NCURSES;
+	} else if (name == "ansi") {
+	    return RenderBackend::ANSI;
+	} else if (name == "memory") {
+	    return RenderBackend::MEMORY;
+	} else if (name == "null") {
+	    return RenderBackend::NONE;
+	};
+    };
+    return isatty(STDIN_FILENO) && isatty(STDOUT_FILENO) ?
+	RenderBackend::NCURSES : RenderBackend::ANSI;
+};
+
+std::unique_ptr<ConsoleWriter::Renderer>
+ConsoleWriter::make_renderer
+(RenderBackend const backend) {
+    switch (backend) {
+    case RenderBackend::NCURSES:
+	return std::make_unique<NcursesRenderer>();
+    case RenderBackend::ANSI:
+	return std::make_unique<AnsiRenderer>
+	    (std::cout, isatty(STDOUT_FILENO) && !std::getenv("NO_COLOR"));
+    case RenderBackend::MEMORY:
+	return std::make_unique<MemoryRenderer>();
+    default:
+	return std::make_unique<NullRenderer>();
+    };
+};
@@ -0,0 +1,82 @@
+#ifndef CLASS_RENDERER
+#define CLASS_RENDERER
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "message.hpp"
+#include "ring_buffer.hpp"
+
+namespace ConsoleWriter {
+    // Where the console draws. Every call comes from the console thread
+    // except the input ones, which the input thread makes, so a backend
+    // only has to guard state it shares with its own readers.
+    class Renderer {
+    public:
+	static constexpr int NO_KEY { -1 };
+
+	virtual ~Renderer() = default;
+
+	// the log area is split into count panes stacked top to bottom,
+	// each under a title row when there is more than one; the console
+	// redraws every pane after a change and never asks for more than
+	// max_panes()
+	virtual size_t max_panes() const noexcept { return 1; }
+	virtual void set_panes(size_t const /* count */) noexcept {}
+	virtual void draw_pane_title(size_t const /* pane */,
+				     std::string const& /* title */) noexcept {}
+
+	virtual int log_rows(size_t const pane) const noexcept = 0;
+	virtual int columns() const noexcept = 0;
+
+	virtual void append_line(size_t const pane,
+				 Message const& message) noexcept = 0;
+	// redraw a pane with the page of history that ends just before
+	// index end, e.g. history.size() for the newest lines
+	virtual void draw_log_page(size_t const pane,
+				   RingBuffer<Message> const& history,
+				   size_t const end) noexcept = 0;
+	virtual void draw_separator(std::string const& label) noexcept = 0;
+	// rows pinned between the log and the separator, taken from the
+	// bottom of the log; the console redraws the panes after a
+	// change. Backends without a screen ignore them
+	virtual void set_status_rows(size_t const /* rows */) noexcept {}
+	virtual void draw_status_row(size_t const /* row */,
+				     std::string const& /* text */) noexcept {}
+	virtual void draw_input_cell(size_t const column, char const character,
+				     bool const is_cursor) noexcept = 0;
+	// end of a frame: push whatever was drawn since the last one
+	virtual void present() noexcept = 0;
+
+	// the console only starts its input thread for backends with keys
+	virtual bool accepts_input() const noexcept { return false; }
+	// true once a key may be waiting, false on timeout
+	virtual bool wait_for_key(int const /* timeout_ms */) noexcept {
+	    return false;
+	}
+	// non-blocking; returns NO_KEY when no key is waiting
+	virtual int read_key() noexcept { return NO_KEY; }
+
+	// timestamp and chunks as one line, without colour
+	static std::string plain_text(Message const& message);
+	// log rows of each pane when area rows hold count panes, each under
+	// a title row when there is more than one; fewer panes when they
+	// would not get a row each
+	static std::vector<int> split_rows(int const area, size_t const count);
+    };
+
+    enum class RenderBackend {
+	NCURSES,
+	ANSI,
+	MEMORY,
+	NONE
+    };
+
+    // FBCURSES_RENDERER=ncurses|ansi|memory|null picks the backend;
+    // otherwise curses on a terminal and the ANSI stream anywhere else
+    RenderBackend default_render_backend() noexcept;
+    std::unique_ptr<Renderer> make_renderer(RenderBackend const backend);
+};
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef CLASS_RING_BUFFER
+#define CLASS_RING_BUFFER
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ConsoleWriter {
+    // Fixed-capacity circular buffer that overwrites its oldest entry once
+    // full. Storage grows with the entries, never past the capacity, so a
+    // large scrollback costs nothing until it is used; once full, inserts
+    // move into an existing slot and never allocate. Index 0 is the
+    // oldest entry.
+    template <typename T>
+    class RingBuffer {
+    public:
+	explicit RingBuffer(size_t const capacity);
+
+	void push_back(T&& value);
+	void set_capacity(size_t const capacity);
+	void clear() noexcept;
+
+	T const& operator[](size_t const index) const noexcept {
+	    return _slots[(_head + index) % _capacity];
+	}
+	T const& back() const noexcept { return (*this)[_size - 1]; }
+
+	size_t size() const noexcept { return _size; }
+	size_t capacity() const noexcept { return _capacity; }
+	bool empty() const noexcept { return _size == 0; }
+    private:
+	std::vector<T> _slots;
+	size_t _capacity { 1 };
+	size_t _head { 0 };
+	size_t _size { 0 };
+    };
+};
+
+template <typename T>
+ConsoleWriter::RingBuffer<T>::RingBuffer
+(size_t const capacity)
+    : _capacity(capacity > 0 ? capacity : 1) {
+};
+
+template <typename T>
+void
+ConsoleWriter::RingBuffer<T>::push_back
+(T&& value) {
+    if (_slots.size() < _capacity) {
+	// still filling for the first time; grow by doubling, but never
+	// past the capacity
+	if (_slots.size() == _slots.capacity()) {
+	    const size_t grown = _slots.size() < 8 ? 16 : _slots.size() * 2;
+	    _slots.reserve(grown < _capacity ? grown : _capacity);
+	};
+	_slots.push_back(std::move(value));
+	++_size;
+	return;
+    };
+    _slots[_head] = std::move(value);
+    _head = (_head + 1) % _capacity;
+};
+
+template <typename T>
+void
+ConsoleWriter::RingBuffer<T>::set_capacity
+(size_t const capacity) {
+    const size_t new_capacity = capacity > 0 ? capacity : 1;
+    if (new_capacity == _capacity) {
+	return;
+    };
+    // keep the newest entries that still fit
+    const size_t keep = _size < new_capacity ? _size : new_capacity;
+    std::vector<T> slots;
+    slots.reserve(keep);
+    for (size_t i = _size - keep; i < _size; ++i) {
+	slots.push_back(std::move(_slots[(_head + i) % _capacity]));
+    };
+    _slots = std::move(slots);
+    _capacity = new_capacity;
+    _head = 0;
+    _size = keep;
+};
+
+template <typename T>
+void
+ConsoleWriter::RingBuffer<T>::clear
+() noexcept {
+    _slots.clear();
+    _head = 0;
+    _size = 0;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef CLASS_SPSC_RING
+#define CLASS_SPSC_RING
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "mpsc_queue.hpp"
+
+namespace ConsoleWriter {
+    // Bounded single-producer, single-consumer ring.
+    //
+    // The producer only writes _head and the consumer only writes _tail,
+    // each on its own cache line. Both sides keep a private copy of the
+    // other's index and only reread the shared one when the ring looks
+    // full (or empty), so a producer that keeps up never touches a line
+    // the consumer writes.
+    template <typename T>
+    class SpscRing {
+    public:
+	explicit SpscRing(size_t const capacity);
+	~SpscRing();
+
+	SpscRing(SpscRing const& other) = delete;
+	SpscRing &operator=(SpscRing const& other) = delete;
+
+	// producer side
+	bool try_push(T&& value) noexcept;
+
+	// consumer side; front() is nullptr when the ring is empty
+	T* front() noexcept;
+	void pop() noexcept;
+
+	size_t capacity() const noexcept { return _mask + 1; }
+	size_t size_approx() const noexcept {
+	    return _head.load(std::memory_order_relaxed) -
+		_tail.load(std::memory_order_relaxed);
+	}
+    private:
+	struct Slot {
+	    alignas(T) unsigned char _storage[sizeof(T)];
+
+	    T* value() noexcept {
+		return std::launder(reinterpret_cast<T*>(_storage));
+	    }
+	};
+
+	size_t const _mask;
+	std::unique_ptr<Slot[]> _slots;
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> _head { 0 };
+	size_t _cached_tail { 0 };
+	alignas(CACHE_LINE_SIZE) std::atomic<size_t> _tail { 0 };
+	size_t _cached_head { 0 };
+    };
+};
+
+template <typename T>
+ConsoleWriter::SpscRing<T>::SpscRing
+(size_t const capacity)
+    : _mask([capacity] () {
+	size_t rounded = 2;
+	while (rounded < capacity) {
+	    rounded <<= 1;
+	};
+	return rounded - 1;
+    } ())
+    , _slots(std::make_unique<Slot[]>(_mask + 1)) {
+};
+
+template <typename T>
+ConsoleWriter::SpscRing<T>::~SpscRing
+() {
+    while (front()) {
+	pop();
+    };
+};
+
+template <typename T>
+bool
+ConsoleWriter::SpscRing<T>::try_push
+(T&& value) noexcept {
+    const size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _cached_tail > _mask) {
+	_cached_tail = _tail.load(std::memory_order_acquire);
+	if (head - _cached_tail > _mask) {
+	    return false;
+	};
+    };
+    new (_slots[head & _mask]._storage) T(std::move(value));
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+};
+
+template <typename T>
+T*
+ConsoleWriter::SpscRing<T>::front
+() noexcept {
+    const size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _cached_head) {
+	_cached_head = _head.load(std::memory_order_acquire);
+	if (tail == _cached_head) {
+	    return nullptr;
+	};
+    };
+    return _slots[tail & _mask].value();
+};
+
+template <typename T>
+void
+ConsoleWriter::SpscRing<T>::pop
+() noexcept {
+    const size_t tail = _tail.load(std::memory_order_relaxed);
+    _slots[tail & _mask].value()->~T();
+    _tail.store(tail + 1, std::memory_order_release);
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "status_board.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+ConsoleWriter::StatusWidget::StatusWidget
+(std::string&& name, std::weak_ptr<StatusBoard>&& board) noexcept
+    : _name(std::move(name))
+    , _board(std::move(board)) {
+};
+
+void
+ConsoleWriter::StatusWidget::touch
+() noexcept {
+    // a plain load while the row already waits for a frame, so a hot
+    // update loop never writes the flag's cache line
+    if (_dirty.load() || _dirty.exchange(true)) {
+	return;
+    };
+    if (auto board = _board.lock()) {
+	board->notify();
+    };
+};
+
+void
+ConsoleWriter::ProgressWidget::set
+(uint64_t const done, uint64_t const total) noexcept {
+    _total.store(total);
+    _done.store(done);
+    touch();
+};
+
+void
+ConsoleWriter::ProgressWidget::advance
+(uint64_t const count) noexcept {
+    _done.fetch_add(count);
+    touch();
+};
+
+std::string
+ConsoleWriter::ProgressWidget::render
+(size_t const width, Clock::time_point const) {
+    const uint64_t total = _total.load();
+    const uint64_t done = std::min(_done.load(), total);
+    const double fraction = total == 0 ? 0.0 :
+	static_cast<double>(done) / static_cast<double>(total);
+    std::stringstream suffix;
+    suffix << "] " << static_cast<int>(fraction * 100.0) << "% " << done
+	   << "/" << total;
+    const size_t fixed = name().size() + 2 + suffix.str().size();
+    const size_t bar = width > fixed ? std::min<size_t>(width - fixed, 50) :
+	0;
+    const size_t filled = static_cast<size_t>
+	(fraction * static_cast<double>(bar));
+    std::string text = name() + " [";
+    text.append(filled, '#');
+    text.append(bar - filled, '.');
+    return text + suffix.str();
+};
+
+void
+ConsoleWriter::CounterWidget::set
+(int64_t const value) noexcept {
+    _value.store(value);
+    touch();
+};
+
+void
+ConsoleWriter::CounterWidget::add
+(int64_t const count) noexcept {
+    _value.fetch_add(count);
+    touch();
+};
+
+std::string
+ConsoleWriter::CounterWidget::render
+(size_t const, Clock::time_point const) {
+    return name() + ": " + std::to_string(_value.load());
+};
+
+void
+ConsoleWriter::RateWidget::mark
+(uint64_t const count) noexcept {
+    _total.fetch_add(count);
+    touch();
+};
+
+std::string
+ConsoleWriter::RateWidget::render
+(size_t const, Clock::time_point const now) {
+    const uint64_t total = _total.load();
+    const auto elapsed = now - _window_start;
+    if (elapsed >= WINDOW || (!_measured && elapsed > Clock::duration(0))) {
+	// until a whole window has passed, the rate so far
+	_rate = static_cast<double>(total - _window_total) /
+	    std::chrono::duration<double>(elapsed).count();
+    };
+    if (elapsed >= WINDOW) {
+	_measured = true;
+	_window_start = now;
+	_window_total = total;
+    };
+    std::stringstream ss;
+    ss.setf(std::ios::fixed);
+    ss.precision(1);
+    ss << name() << ": " << _rate << "/s (total " << total << ")";
+    return ss.str();
+};
+
+ConsoleWriter::StatusWidget::Clock::time_point
+ConsoleWriter::RateWidget::next_refresh
+() const noexcept {
+    // an idle meter settles at 0/s and then stops asking for frames
+    if (_rate == 0.0 && _total.load() == _window_total) {
+	return Clock::time_point::max();
+    };
+    return _window_start + WINDOW;
+};
+
+template <typename Widget>
+std::shared_ptr<Widget>
+ConsoleWriter::StatusBoard::find_or_add
+(std::string&& name) {
+    std::shared_ptr<Widget> widget;
+    {
+	std::scoped_lock<std::mutex> lock(_lock);
+	const auto found = std::find_if
+	    (_widgets.begin(), _widgets.end(),
+	     [&] (auto const& w) { return w->name() == name; });
+	if (found != _widgets.end()) {
+	    widget = std::dynamic_pointer_cast<Widget>(*found);
+	    if (!widget) {
+		throw std::invalid_argument("status widget \"" + name +
+					    "\" is another kind");
+	    };
+	    return widget;
+	};
+	widget = std::make_shared<Widget>(std::move(name), weak_from_this());
+	_widgets.push_back(widget);
+	_relayout = true;
+    }
+    notify();
+    return widget;
+};
+
+std::shared_ptr<ConsoleWriter::ProgressWidget>
+ConsoleWriter::StatusBoard::progress
+(std::string name) {
+    return find_or_add<ProgressWidget>(std::move(name));
+};
+
+std::shared_ptr<ConsoleWriter::CounterWidget>
+ConsoleWriter::StatusBoard::counter
+(std::string name) {
+    return find_or_add<CounterWidget>(std::move(name));
+};
+
+std::shared_ptr<ConsoleWriter::RateWidget>
+ConsoleWriter::StatusBoard::rate
+(std::string name) {
+    return find_or_add<RateWidget>(std::move(name));
+};
+
+void
+ConsoleWriter::StatusBoard::remove
+(std::string const& name) {
+    {
+	std::scoped_lock<std::mutex> lock(_lock);
+	const auto found = std::find_if
+	    (_widgets.begin(), _widgets.end(),
+	     [&] (auto const& w) { return w->name() == name; });
+	if (found == _widgets.end()) {
+	    return;
+	};
+	_widgets.erase(found);
+	_relayout = true;
+    }
+    notify();
+};
+
+void
+ConsoleWriter::StatusBoard::set_waker
+(std::function<void()>&& wake) {
+    std::scoped_lock<std::mutex> lock(_wake_lock);
+    _wake = std::move(wake);
+};
+
+void
+ConsoleWriter::StatusBoard::notify
+() noexcept {
+    if (_pending.exchange(true)) {
+	return;
+    };
+    std::scoped_lock<std::mutex> lock(_wake_lock);
+    if (_wake) {
+	// a throwing waker costs one wake-up, not the updating thread
+	try {
+	    _wake();
+	} catch (...) {
+	};
+    };
+};
+
+size_t
+ConsoleWriter::StatusBoard::rows
+() const {
+    std::scoped_lock<std::mutex> lock(_lock);
+    return _widgets.size();
+};
+
+void
+ConsoleWriter::StatusBoard::refresh
+(size_t const width, Clock::time_point const now, bool const all,
+ std::function<void(size_t, std::string const&)> const& draw) {
+    // cleared first: an update from here on wakes the next frame
+    _pending.store(false);
+    std::scoped_lock<std::mutex> lock(_lock);
+    const bool every_row = all || _relayout;
+    _relayout = false;
+    Clock::time_point next = Clock::time_point::max();
+    for (size_t row = 0; row < _widgets.size(); ++row) {
+	StatusWidget& widget = *_widgets[row];
+	const bool dirty = widget._dirty.exchange(false);
+	if (every_row || dirty || now >= widget.next_refresh()) {
+	    draw(row, widget.render(width, now));
+	};
+	next = std::min(next, widget.next_refresh());
+    };
+    _next_refresh.store(next.time_since_epoch().count(),
+			std::memory_order_relaxed);
+};
@@ -0,0 +1,163 @@
+#ifndef CLASS_STATUS_BOARD
+#define CLASS_STATUS_BOARD
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ConsoleWriter {
+    class StatusBoard;
+
+    // One row of the console's pinned status region. Any thread may
+    // update a widget as often as it likes: an update is an atomic store
+    // and, the first time after a frame, one wake of the console. The
+    // console formats the row at most once per frame however many updates
+    // landed in between.
+    class StatusWidget {
+    public:
+	using Clock = std::chrono::steady_clock;
+
+	virtual ~StatusWidget() = default;
+
+	StatusWidget(StatusWidget const& other) = delete;
+	StatusWidget &operator=(StatusWidget const& other) = delete;
+
+	std::string const& name() const noexcept { return _name; }
+    protected:
+	StatusWidget(std::string&& name,
+		     std::weak_ptr<StatusBoard>&& board) noexcept;
+
+	// marks the row for the next frame
+	void touch() noexcept;
+
+	// console thread only
+	virtual std::string render(size_t const width,
+				   Clock::time_point const now) = 0;
+	// when the row goes stale without updates, e.g. a rate decaying
+	virtual Clock::time_point next_refresh() const noexcept {
+	    return Clock::time_point::max();
+	}
+    private:
+	friend class StatusBoard;
+
+	std::string const _name;
+	std::weak_ptr<StatusBoard> const _board;
+	std::atomic<bool> _dirty { true };
+    };
+
+    // name [#########...........] 45% 450/1000
+    class ProgressWidget final : public StatusWidget {
+    public:
+	ProgressWidget(std::string&& name,
+		       std::weak_ptr<StatusBoard>&& board) noexcept
+	    : StatusWidget(std::move(name), std::move(board)) {}
+
+	void set(uint64_t const done, uint64_t const total) noexcept;
+	void advance(uint64_t const count = 1) noexcept;
+    private:
+	std::string render(size_t const width,
+			   Clock::time_point const now) override;
+
+	std::atomic<uint64_t> _done { 0 };
+	std::atomic<uint64_t> _total { 0 };
+    };
+
+    // name: 1234
+    class CounterWidget final : public StatusWidget {
+    public:
+	CounterWidget(std::string&& name,
+		      std::weak_ptr<StatusBoard>&& board) noexcept
+	    : StatusWidget(std::move(name), std::move(board)) {}
+
+	void set(int64_t const value) noexcept;
+	void add(int64_t const count = 1) noexcept;
+    private:
+	std::string render(size_t const width,
+			   Clock::time_point const now) override;
+
+	std::atomic<int64_t> _value { 0 };
+    };
+
+    // name: 1234.5/s (total 98765), over the last second or so
+    class RateWidget final : public StatusWidget {
+    public:
+	RateWidget(std::string&& name,
+		   std::weak_ptr<StatusBoard>&& board) noexcept
+	    : StatusWidget(std::move(name), std::move(board)) {}
+
+	void mark(uint64_t const count = 1) noexcept;
+    private:
+	static constexpr std::chrono::seconds WINDOW { 1 };
+
+	std::string render(size_t const width,
+			   Clock::time_point const now) override;
+	Clock::time_point next_refresh() const noexcept override;
+
+	std::atomic<uint64_t> _total { 0 };
+	// console thread: the window the rate is measured over
+	Clock::time_point _window_start { Clock::now() };
+	uint64_t _window_total { 0 };
+	bool _measured { false };
+	double _rate { 0.0 };
+    };
+
+    // The named widgets of one console, in the order they were created.
+    // Widgets hold the board weakly, so a handle kept after the console
+    // is gone just stops drawing.
+    class StatusBoard final :
+	public std::enable_shared_from_this<StatusBoard> {
+    public:
+	using Clock = StatusWidget::Clock;
+
+	// the widget called name, created on first use; throws
+	// std::invalid_argument if name is taken by another kind
+	std::shared_ptr<ProgressWidget> progress(std::string name);
+	std::shared_ptr<CounterWidget> counter(std::string name);
+	std::shared_ptr<RateWidget> rate(std::string name);
+	// the rows below it move up
+	void remove(std::string const& name);
+
+	// called once per burst of updates, from the updating thread;
+	// anything it throws is dropped
+	void set_waker(std::function<void()>&& wake);
+
+	// console thread: true once a widget has changed since the last
+	// refresh, and when a row goes stale without one
+	bool pending() const noexcept { return _pending.load(); }
+	Clock::time_point next_refresh() const noexcept {
+	    return Clock::time_point(Clock::duration(
+		_next_refresh.load(std::memory_order_relaxed)));
+	}
+	size_t rows() const;
+	// draw(row, text) for every row changed since the last call, or
+	// every row when all is set
+	void refresh(size_t const width, Clock::time_point const now,
+		     bool const all,
+		     std::function<void(size_t, std::string const&)> const&
+		     draw);
+    private:
+	friend class StatusWidget;
+
+	template <typename Widget>
+	std::shared_ptr<Widget> find_or_add(std::string&& name);
+	void notify() noexcept;
+
+	mutable std::mutex _lock;
+	std::vector<std::shared_ptr<StatusWidget>> _widgets;
+	// rows were added or removed, so every row moves
+	bool _relayout { false };
+
+	std::atomic<bool> _pending { false };
+	std::atomic<Clock::rep> _next_refresh { Clock::time_point::max()
+	    .time_since_epoch().count() };
+	std::mutex _wake_lock;
+	std::function<void()> _wake;
+    };
+};
+
+#endif
@@ -1,8 +1,15 @@
 #include "threaded_process.hpp"
-#include "numerical.hpp"
+#include "unique_id.hpp"
 
+#include <algorithm>
 #include <sstream>
 
+ThreadedProcess::ThreadedProcess
+()
+    : _unique_id(Numerical::UniqueIdGenerator::process_ids().next())
+{
+}
+
 ThreadedProcess::ThreadedProcess
 (uint64_t const unique_id)
     : _unique_id(unique_id)
@@ -16,34 +23,52 @@ ThreadedProcess::~ThreadedProcess
     };
 }
 
+void
+ThreadedProcess::launch
+() {
+    if (!_launched.exchange(true)) {
+	start();
+    };
+};
+
+void
+ThreadedProcess::set_deletable
+() noexcept {
+    if (!_deletable.exchange(true)) {
+	_finished.set_value();
+    };
+};
+
 void
 ThreadedProcess::add_dependency
 (ThreadedProcess& other_process) {
-    std::scoped_lock<std::mutex> lock(_dependencies_mutex);
-    if (std::find(_dependencies.cbegin(),
-		  _dependencies.cend(),
-		  other_process.get_unique_id()) == _dependencies.cend()) {
-	_dependencies.push_back(other_process.get_unique_id());
-	other_process.add_dependent_callback( [&] (const uint64_t input) {
-	    this->remove_dependency(input); });
+    {
+	std::scoped_lock<std::mutex> lock(_dependencies->_lock);
+	if (!_dependencies->_ids.insert(other_process.get_unique_id())
+	    .second) {
+	    return;
+	};
     }
+    std::weak_ptr<Dependencies> dependencies = _dependencies;
+    other_process.add_dependent_callback
+	([dependencies] (const uint64_t input) {
+	    if (auto alive = dependencies.lock()) {
+		std::scoped_lock<std::mutex> lock(alive->_lock);
+		alive->_ids.erase(input);
+	    };
+	});
 };
 
 void
 ThreadedProcess::remove_dependency
 (const uint64_t process_id) {
-    std::scoped_lock<std::mutex> lock(_dependencies_mutex);
-    const auto it = std::find(_dependencies.cbegin(),
-			      _dependencies.cend(),
-			      process_id);
-    if (it != _dependencies.cend()) {
-	_dependencies.erase(it);
-    };
+    std::scoped_lock<std::mutex> lock(_dependencies->_lock);
+    _dependencies->_ids.erase(process_id);
 };
 
 bool ThreadedProcess::has_dependencies() const {
-    std::scoped_lock<std::mutex> lock(_dependencies_mutex);
-    return !_dependencies.empty();
+    std::scoped_lock<std::mutex> lock(_dependencies->_lock);
+    return !_dependencies->_ids.empty();
 };
 
 bool
@@ -62,12 +87,48 @@ ThreadedProcess::add_dependent_callback
 bool
 ThreadedProcess::can_exit_loop
 (bool const control_bool) const {
-    std::scoped_lock<std::mutex> lock(_dependencies_mutex);
-    return !control_bool && _dependencies.empty();
+    return !control_bool && !has_dependencies();
 };
 
 void
 ThreadedProcess::shutdown
 () noexcept {
     _running = false;
+    on_shutdown();
+    resume();
+};
+
+void
+ThreadedProcess::start_cooperative
+(ProcessExecutor& executor) {
+    _task = executor.make_task([this] () { return this->run_once(); });
+    _task->wake();
+};
+
+void
+ThreadedProcess::resume
+() noexcept {
+    if (_task) {
+	_task->wake();
+    };
+};
+
+void
+ThreadedProcess::resume_at
+(ProcessExecutor::Clock::time_point const deadline) {
+    if (_task) {
+	_task->wake_at(deadline);
+    };
+};
+
+void
+ThreadedProcess::join
+() noexcept {
+    if (_thread && _thread->joinable()) {
+	_thread->join();
+    };
+    if (_task) {
+	_finished_future.wait();
+	_task->detach();
+    };
 };
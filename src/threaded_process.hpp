@@ -6,12 +6,27 @@
 #include <atomic>
 #include <thread>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
+#include <unordered_set>
+
+#include "process_executor.hpp"
+
+// How a ThreadedProcess runs: on its own std::thread, looping in start()'s
+// thread function, or as a task on a shared ProcessExecutor, where
+// run_once() is called each time the process is resumed.
+enum class ExecutionMode {
+    DEDICATED_THREAD,
+    COOPERATIVE
+};
 
 class ThreadedProcess {
 public:
-    ThreadedProcess(uint64_t const unique_id);
+    // takes the next ID from UniqueIdGenerator::process_ids()
+    ThreadedProcess();
+    // the caller guarantees the ID is unique and not 0
+    explicit ThreadedProcess(uint64_t const unique_id);
     virtual ~ThreadedProcess();
 
     ThreadedProcess(ThreadedProcess &&other) = delete;
@@ -24,6 +39,13 @@ public:
     virtual void start() = 0;
     // END OF PURE VIRTUAL FUNCTIONS
 
+    // start() the first time it is called, nothing after that
+    void launch();
+    bool launched() const noexcept { return _launched.load(); }
+    // ready once the process has finished and set itself deletable
+    std::shared_future<void> finished() const { return _finished_future; }
+
+    // this process is not deletable until process has been destroyed
     void add_dependency(ThreadedProcess& process);
     void remove_dependency(uint64_t const process_id);
 
@@ -35,14 +57,49 @@ public:
 
     virtual void shutdown() noexcept final;
 protected:
+    // called by shutdown() once _running is cleared, so processes that
+    // block waiting for work can wake up and notice
+    virtual void on_shutdown() noexcept {}
+
+    // COOPERATIVE mode. run_once() does whatever work is pending without
+    // blocking and returns true if it stopped early and wants another
+    // turn. Once it sees !_running it must finish up and call
+    // set_deletable().
+    virtual bool run_once() { return false; }
+    void start_cooperative(ProcessExecutor& executor =
+			   ProcessExecutor::shared());
+    // run_once() again soon; coalesces, cheap enough to call per message
+    void resume() noexcept;
+    void resume_at(ProcessExecutor::Clock::time_point const deadline);
+    // waits for the dedicated thread, or for the task to finish and
+    // detaches it; subclasses call it from their destructor, after
+    // shutdown(), while run_once() can still be called
+    void join() noexcept;
+
+    // the end of the process's loop; fulfils finished()
+    void set_deletable() noexcept;
+
+    // shared so that a callback held by a dependency which outlives this
+    // process finds it gone rather than dangling
+    struct Dependencies {
+	std::mutex _lock;
+	std::unordered_set<uint64_t> _ids;
+    };
+
     mutable std::mutex _dependencies_mutex;
-    std::vector<uint64_t> _dependencies;
+    std::shared_ptr<Dependencies> _dependencies {
+	std::make_shared<Dependencies>() };
     std::vector<std::function<void(uint64_t)>> _dependent_callbacks;
-    
+
+
     std::shared_ptr<std::thread> _thread { nullptr };
+    std::shared_ptr<ProcessExecutor::Task> _task { nullptr };
     std::atomic<bool> _running { false };
     std::atomic<bool> _shutdown { false };
     std::atomic<bool> _deletable { false };
+    std::atomic<bool> _launched { false };
+    std::promise<void> _finished;
+    std::shared_future<void> _finished_future { _finished.get_future() };
     uint64_t _unique_id { 0 };
 };
 
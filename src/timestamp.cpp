@@ -0,0 +1,130 @@
+#include "timestamp.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+
+namespace {
+    using namespace ConsoleWriter;
+
+    std::atomic<Timestamp::Precision> _precision
+    { Timestamp::Precision::SECONDS };
+
+    struct Anchor {
+	std::chrono::system_clock::time_point _wall;
+	Timestamp::Clock::time_point _steady;
+    };
+
+    Anchor const&
+    anchor
+    () noexcept {
+	static const Anchor shared { std::chrono::system_clock::now(),
+				     Timestamp::Clock::now() };
+	return shared;
+    };
+
+    // "YYYY-MM-DD HH:MM:SS"
+    constexpr size_t SECONDS_WIDTH { 19 };
+
+    struct SecondCache {
+	int64_t _second { -1 };
+	char _text[SECONDS_WIDTH + 1];
+    };
+
+    thread_local SecondCache _cache;
+
+    void
+    write_digits
+    (char* out, int64_t value, size_t const digits) noexcept {
+	for (size_t i = digits; i > 0; --i) {
+	    out[i - 1] = static_cast<char>('0' + value % 10);
+	    value /= 10;
+	};
+    };
+};
+
+void
+ConsoleWriter::Timestamp::set_precision
+(Precision const precision) noexcept {
+    _precision.store(precision, std::memory_order_relaxed);
+};
+
+ConsoleWriter::Timestamp::Precision
+ConsoleWriter::Timestamp::precision
+() noexcept {
+    return _precision.load(std::memory_order_relaxed);
+};
+
+std::chrono::system_clock::time_point
+ConsoleWriter::Timestamp::to_wall
+(Clock::time_point const stamp) noexcept {
+    using namespace std::chrono;
+    const Anchor& base = anchor();
+    return base._wall +
+	duration_cast<system_clock::duration>(stamp - base._steady);
+};
+
+size_t
+ConsoleWriter::Timestamp::format
+(Clock::time_point const stamp, bool const padded, char* buffer) noexcept {
+    return format_wall(to_wall(stamp), padded, buffer);
+};
+
+size_t
+ConsoleWriter::Timestamp::format_wall
+(std::chrono::system_clock::time_point const wall, bool const padded,
+ char* buffer) noexcept {
+    using namespace std::chrono;
+    const int64_t micros = duration_cast<microseconds>
+	(wall.time_since_epoch()).count();
+    int64_t second = micros / 1000000;
+    int64_t fraction = micros % 1000000;
+    if (fraction < 0) {
+	fraction += 1000000;
+	--second;
+    };
+
+    if (second != _cache._second) {
+	const time_t seconds = static_cast<time_t>(second);
+	struct tm local;
+	localtime_r(&seconds, &local);
+	strftime(_cache._text, sizeof(_cache._text),
+		 "%Y-%m-%d %H:%M:%S", &local);
+	_cache._second = second;
+    };
+
+    size_t length = 0;
+    if (padded) {
+	buffer[length++] = '[';
+    };
+    std::memcpy(buffer + length, _cache._text, SECONDS_WIDTH);
+    length += SECONDS_WIDTH;
+    switch (precision()) {
+    case Precision::MILLISECONDS: {
+	buffer[length++] = '.';
+	write_digits(buffer + length, fraction / 1000, 3);
+	length += 3;
+	break;
+    }
+    case Precision::MICROSECONDS: {
+	buffer[length++] = '.';
+	write_digits(buffer + length, fraction, 6);
+	length += 6;
+	break;
+    }
+    default: {
+	break;
+    };
+    };
+    if (padded) {
+	buffer[length++] = ']';
+    };
+    return length;
+};
+
+std::string
+ConsoleWriter::Timestamp::to_string
+(Clock::time_point const stamp, bool const padded) {
+    char buffer[MAX_WIDTH];
+    return std::string(buffer, format(stamp, padded, buffer));
+};
@@ -0,0 +1,46 @@
+#ifndef NAMESPACE_TIMESTAMP
+#define NAMESPACE_TIMESTAMP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace ConsoleWriter {
+    // Enqueue-time stamping and cached wall-clock formatting.
+    //
+    // Producers only read the monotonic clock. Formatting converts that
+    // reading to wall-clock time through an anchor taken once at start-up,
+    // and each thread caches the "YYYY-MM-DD HH:MM:SS" text of the last
+    // second it formatted, so localtime_r/strftime run at most once per
+    // second per formatting thread.
+    namespace Timestamp {
+	using Clock = std::chrono::steady_clock;
+
+	enum class Precision {
+	    SECONDS,
+	    MILLISECONDS,
+	    MICROSECONDS
+	};
+
+	// "[YYYY-MM-DD HH:MM:SS.uuuuuu]"
+	static constexpr size_t MAX_WIDTH { 28 };
+
+	inline Clock::time_point now() noexcept { return Clock::now(); }
+
+	void set_precision(Precision const precision) noexcept;
+	Precision precision() noexcept;
+
+	std::chrono::system_clock::time_point
+	to_wall(Clock::time_point const stamp) noexcept;
+
+	// writes at most MAX_WIDTH bytes, no terminator; returns the length
+	size_t format(Clock::time_point const stamp, bool const padded,
+		      char* buffer) noexcept;
+	size_t format_wall(std::chrono::system_clock::time_point const wall,
+			   bool const padded, char* buffer) noexcept;
+	std::string to_string(Clock::time_point const stamp,
+			      bool const padded);
+    };
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "unique_id.hpp"
+
+namespace {
+    using Numerical::UniqueIdGenerator;
+
+    std::atomic<uint64_t> _next_serial { 1 };
+
+    // the calling thread's block in whichever generator it last used
+    struct LocalBlock {
+	uint64_t _owner { 0 };
+	uint64_t _next { 0 };
+	uint64_t _end { 0 };
+    };
+
+    thread_local LocalBlock _local;
+};
+
+Numerical::UniqueIdGenerator::UniqueIdGenerator
+(Mode const mode, uint64_t const seed) noexcept
+    : _serial(_next_serial.fetch_add(1, std::memory_order_relaxed))
+    , _mode(mode)
+    , _key(mode == Mode::RANDOM ? splitmix64(seed) : 0) {
+};
+
+uint64_t
+Numerical::UniqueIdGenerator::splitmix64
+(uint64_t value) noexcept {
+    value += 0x9e3779b97f4a7c15;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+    return value ^ (value >> 31);
+};
+
+uint64_t
+Numerical::UniqueIdGenerator::next_block
+() noexcept {
+    _local._owner = _serial;
+    _local._next = _next_block.fetch_add(BLOCK_SIZE,
+					 std::memory_order_relaxed);
+    _local._end = _local._next + BLOCK_SIZE;
+    return _local._next;
+};
+
+uint64_t
+Numerical::UniqueIdGenerator::next
+() noexcept {
+    while (true) {
+	if (_local._owner != _serial || _local._next == _local._end) {
+	    next_block();
+	};
+	const uint64_t counter = _local._next++;
+	// counter + key and the finaliser are both bijections, so
+	// distinct counters still give distinct IDs; only the one that
+	// lands on 0 is skipped
+	const uint64_t id = _mode == Mode::RANDOM ?
+	    splitmix64(counter + _key) : counter + 1;
+	if (id != 0) {
+	    return id;
+	};
+    };
+};
+
+Numerical::UniqueIdGenerator&
+Numerical::UniqueIdGenerator::process_ids
+() noexcept {
+    static UniqueIdGenerator generator;
+    return generator;
+};
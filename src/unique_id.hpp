@@ -0,0 +1,50 @@
+#ifndef CLASS_UNIQUE_ID_GENERATOR
+#define CLASS_UNIQUE_ID_GENERATOR
+
+#include <atomic>
+#include <cstdint>
+
+namespace Numerical {
+    // Lock-free source of unique 64-bit IDs, 0 never being one of them.
+    //
+    // Each thread takes a block of BLOCK_SIZE counter values with one
+    // fetch_add and hands them out from a thread_local cache, so a new ID
+    // normally costs an increment and no shared cache line. IDs are unique
+    // across threads but only increase within a thread. RANDOM mode passes
+    // the counter through splitmix64's finaliser, a bijection, so the IDs
+    // look random (useful as hash keys, or to stop callers inferring
+    // creation order) without giving up uniqueness.
+    class UniqueIdGenerator {
+    public:
+	enum class Mode {
+	    SEQUENTIAL,
+	    RANDOM
+	};
+
+	static constexpr uint64_t BLOCK_SIZE { 1024 };
+
+	explicit UniqueIdGenerator(Mode const mode = Mode::SEQUENTIAL,
+				   uint64_t const seed = 0) noexcept;
+
+	UniqueIdGenerator(UniqueIdGenerator const&) = delete;
+	UniqueIdGenerator& operator=(UniqueIdGenerator const&) = delete;
+
+	uint64_t next() noexcept;
+	Mode mode() const noexcept { return _mode; }
+
+	// the generator behind ThreadedProcess IDs
+	static UniqueIdGenerator& process_ids() noexcept;
+
+	static uint64_t splitmix64(uint64_t value) noexcept;
+    private:
+	uint64_t next_block() noexcept;
+
+	// tags thread caches; unlike the address it is never reused
+	const uint64_t _serial;
+	const Mode _mode;
+	const uint64_t _key;
+	std::atomic<uint64_t> _next_block { 0 };
+    };
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include "../src/arguments.hpp"
+#include "check.hpp"
+
+#include <chrono>
+#include <string>
+
+// Splitting, the number and duration parsers, and ArgumentSchema::bind on
+// missing, surplus, malformed and unknown arguments.
+
+namespace {
+    using namespace ConsoleWriter;
+    using namespace std::chrono_literals;
+
+    void
+    test_split
+    () {
+	const Arguments args("copy 'a b' \"c\" --force --every=5s --x=");
+	CHECK(args.size() == 3);
+	CHECK(args[0] == "copy");
+	CHECK(args[1] == "a b");
+	CHECK(args[2] == "c");
+	CHECK(args[3].empty());
+	CHECK(args.flag("force"));
+	CHECK(!args.flag("every"));
+	CHECK(args.option("every") == std::string_view("5s"));
+	CHECK(args.option("x") == std::string_view(""));
+	CHECK(!args.option("force"));
+	// a quoted word is never an option
+	CHECK(Arguments("'--force'")[0] == "--force");
+	CHECK(Arguments("   ").empty());
+    };
+
+    void
+    test_numbers
+    () {
+	CHECK(Arguments::parse_integer("42") == 42);
+	CHECK(Arguments::parse_integer("+7") == 7);
+	CHECK(Arguments::parse_integer("-3") == -3);
+	CHECK(!Arguments::parse_integer(""));
+	CHECK(!Arguments::parse_integer("12x"));
+	CHECK(!Arguments::parse_integer("1.5"));
+	CHECK(!Arguments::parse_integer("99999999999999999999"));
+	CHECK(Arguments::parse_number("2.5") == 2.5);
+	CHECK(Arguments::parse_number("1e3") == 1000.0);
+	CHECK(!Arguments::parse_number("1.5.2"));
+	CHECK(!Arguments::parse_number("abc"));
+	CHECK(!Arguments::parse_number("+"));
+    };
+
+    void
+    test_durations
+    () {
+	CHECK(Arguments::parse_duration("5") == 5s);
+	CHECK(Arguments::parse_duration("5s") == 5s);
+	CHECK(Arguments::parse_duration("250ms") == 250ms);
+	CHECK(Arguments::parse_duration("1.5us") == 1500ns);
+	CHECK(Arguments::parse_duration("10ns") == 10ns);
+	CHECK(Arguments::parse_duration("2m") == 2min);
+	CHECK(Arguments::parse_duration("1h") == 1h);
+	CHECK(!Arguments::parse_duration(""));
+	CHECK(!Arguments::parse_duration("ms"));
+	CHECK(!Arguments::parse_duration("5d"));
+	CHECK(!Arguments::parse_duration("-1s"));
+	// past int64_t nanoseconds
+	CHECK(!Arguments::parse_duration("1e12h"));
+    };
+
+    void
+    test_schema
+    () {
+	const ArgumentSchema schema = ArgumentSchema()
+	    .required("count", ArgumentType::INTEGER)
+	    .optional("scale", ArgumentType::NUMBER)
+	    .option("every", ArgumentType::DURATION)
+	    .flag("quiet");
+	CHECK(schema.usage() ==
+	      "<count> [scale] [--every=<duration>] [--quiet]");
+
+	Arguments missing("");
+	CHECK(schema.bind(missing) == "expected at least 1 argument, got 0");
+	Arguments surplus("1 2 3");
+	CHECK(schema.bind(surplus) == "expected at most 2 arguments, got 3");
+	Arguments bad_integer("ten");
+	CHECK(schema.bind(bad_integer) ==
+	      "count: \"ten\" is not a valid integer");
+	Arguments bad_number("1 lots");
+	CHECK(schema.bind(bad_number) ==
+	      "scale: \"lots\" is not a valid number");
+	Arguments bad_duration("1 --every=soon");
+	CHECK(schema.bind(bad_duration) ==
+	      "--every: \"soon\" is not a valid duration");
+	Arguments unknown_option("1 --loud=1");
+	CHECK(schema.bind(unknown_option) == "unknown option --loud");
+	Arguments unknown_flag("1 --every");
+	CHECK(schema.bind(unknown_flag) == "unknown flag --every");
+
+	Arguments bound("-4 0.5 --every=20ms --quiet");
+	CHECK(schema.bind(bound).empty());
+	CHECK(bound.integer(0) == -4);
+	CHECK(bound.number(1) == 0.5);
+	// an integer reads as a number too, not the other way round
+	CHECK(bound.number(0) == -4.0);
+	CHECK(!bound.integer(1));
+	CHECK(!bound.integer(2));
+	CHECK(bound.option_duration("every") == 20ms);
+	CHECK(!bound.option_integer("every"));
+	CHECK(!bound.option_duration("quiet"));
+	CHECK(bound.flag("quiet"));
+    };
+
+    void
+    test_variadic
+    () {
+	const ArgumentSchema schema = ArgumentSchema()
+	    .required("name", ArgumentType::STRING)
+	    .variadic("values", ArgumentType::INTEGER, 2);
+	CHECK(schema.usage() == "<name> <values...>");
+	Arguments too_few("sum 1");
+	CHECK(schema.bind(too_few) == "expected at least 3 arguments, got 2");
+	Arguments bad("sum 1 2 x");
+	CHECK(schema.bind(bad) == "values: \"x\" is not a valid integer");
+	Arguments good("sum 1 2 3 4");
+	CHECK(schema.bind(good).empty());
+	CHECK(good.integer(4) == 4);
+	CHECK(!good.integer(5));
+    };
+};
+
+int main()
+{
+    test_split();
+    test_numbers();
+    test_durations();
+    test_schema();
+    test_variadic();
+    return Tests::failures();
+}
@@ -0,0 +1,39 @@
+#ifndef TESTS_CHECK
+#define TESTS_CHECK
+
+#include <cstdio>
+
+// Assertions for the test programs: a failed CHECK prints the expression
+// and carries on, and main returns failures() so ctest sees any of them.
+
+namespace Tests {
+    inline int _failures { 0 };
+
+    inline bool
+    check
+    (bool const passed, char const* expression, char const* file,
+     int const line) {
+	if (!passed) {
+	    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line,
+			 expression);
+	    ++_failures;
+	};
+	return passed;
+    };
+
+    inline int
+    failures
+    () {
+	if (_failures > 0) {
+	    std::fprintf(stderr, "%d check%s failed\n", _failures,
+			 _failures == 1 ? "" : "s");
+	};
+	return _failures == 0 ? 0 : 1;
+    };
+};
+
+#define CHECK(EXPRESSION)\
+    Tests::check(static_cast<bool>(EXPRESSION), #EXPRESSION, __FILE__,\
+		 __LINE__)
+
+#endif
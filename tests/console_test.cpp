@@ -0,0 +1,175 @@
+#include "../src/console.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Drives a whole ConsoleInterface through a MemoryRenderer: messages,
+// typed commands and their errors, the repeat filter, and paging through
+// the scrollback with the keyboard. The console renders on its own
+// thread, so every check waits for the screen to catch up.
+
+namespace {
+    using namespace ConsoleWriter;
+    using Clock = std::chrono::steady_clock;
+
+    // ncurses key codes, as ConsoleInterface reads them
+    constexpr int PAGE_DOWN { 338 };
+    constexpr int PAGE_UP { 339 };
+
+    bool
+    ends_with
+    (std::string const& line, std::string const& tail) {
+	return line.size() >= tail.size() &&
+	    line.compare(line.size() - tail.size(), tail.size(), tail) == 0;
+    };
+
+    size_t
+    count_lines
+    (std::vector<std::string> const& lines, std::string const& tail) {
+	return static_cast<size_t>(std::count_if
+	    (lines.begin(), lines.end(), [&] (std::string const& line) {
+		return ends_with(line, tail);
+	    }));
+    };
+
+    // true once predicate holds, false after two seconds without
+    template <typename Predicate>
+    bool
+    wait_until
+    (Predicate&& predicate) {
+	const auto deadline = Clock::now() + std::chrono::seconds(2);
+	while (!predicate()) {
+	    if (Clock::now() > deadline) {
+		return false;
+	    };
+	    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	};
+	return true;
+    };
+
+    bool
+    shows
+    (MemoryRenderer const& renderer, std::string const& tail) {
+	return wait_until([&] () {
+	    return count_lines(renderer.screen(), tail) > 0;
+	});
+    };
+
+    void
+    test_messages
+    (MemoryRenderer const& renderer) {
+	timestamped_message("first message");
+	error_message("something broke");
+	CHECK(shows(renderer, "first message"));
+	CHECK(shows(renderer, "[ERROR] something broke"));
+    };
+
+    void
+    test_commands
+    (MemoryRenderer& renderer) {
+	auto sum = std::make_shared<Command>
+	    ("Add whole numbers.",
+	     ArgumentSchema().variadic("values", ArgumentType::INTEGER, 1),
+	     [] (Arguments const& args) {
+		 int64_t total = 0;
+		 for (size_t i = 0; i < args.size(); ++i) {
+		     total += *args.integer(i);
+		 };
+		 return "sum " + std::to_string(total);
+	     });
+	add_command("sum", sum);
+
+	renderer.push_keys("sum 2 3 -4\n");
+	CHECK(shows(renderer, "> sum 2 3 -4"));
+	CHECK(shows(renderer, "sum 1"));
+	renderer.push_keys("sum 2 x\n");
+	CHECK(shows(renderer,
+		    "sum: values: \"x\" is not a valid integer. "
+		    "Usage: sum <values...>"));
+	renderer.push_keys("sum\n");
+	CHECK(shows(renderer, "sum: expected at least 1 argument, got 0. "
+		    "Usage: sum <values...>"));
+	renderer.push_keys("cancel -1\n");
+	CHECK(shows(renderer, "Usage: cancel <job id>"));
+    };
+
+    void
+    test_filter
+    (MemoryRenderer& renderer) {
+	renderer.push_keys("filter --rate=-1\n");
+	CHECK(shows(renderer, "--rate must be 0 (no limit) or more."));
+	renderer.push_keys("filter --burst=0.5\n");
+	CHECK(shows(renderer, "--burst must be at least 1."));
+	renderer.push_keys("filter --window=10s\n");
+	CHECK(shows(renderer, "Repeats within 10000 ms collapse, no rate "
+		    "limit. Collapsed 0, rate limited 0."));
+
+	for (int i = 0; i < 5; ++i) {
+	    timestamped_message("same again");
+	};
+	timestamped_message("after the repeats");
+	CHECK(shows(renderer, "after the repeats"));
+	CHECK(count_lines(renderer.lines(), "same again") == 1);
+    };
+
+    void
+    test_scrollback
+    (MemoryRenderer& renderer) {
+	for (int i = 0; i < 40; ++i) {
+	    timestamped_message("row " + std::to_string(i));
+	};
+	CHECK(shows(renderer, "row 39"));
+	const size_t rows = renderer.screen().size();
+	CHECK(rows > 1);
+
+	// one page up puts the bottom row a page, less one, above the newest
+	renderer.push_key(PAGE_UP);
+	const std::string earlier = "row " + std::to_string(39 - (rows - 1));
+	CHECK(wait_until([&] () {
+	    return ends_with(renderer.screen().back(), earlier);
+	}));
+	CHECK(renderer.separator().find("scrollback") != std::string::npos);
+	// a line arriving while scrolled back leaves the view where it is,
+	// so one page down stops a line short of the newest
+	const std::string held = " " + std::to_string(rows) + " of ";
+	timestamped_message("row 40");
+	CHECK(wait_until([&] () {
+	    return renderer.separator().find(held) != std::string::npos;
+	}));
+	CHECK(ends_with(renderer.screen().back(), earlier));
+	renderer.push_key(PAGE_DOWN);
+	CHECK(wait_until([&] () {
+	    return renderer.separator().find(" 1 of ") != std::string::npos;
+	}));
+	CHECK(ends_with(renderer.screen().back(), "row 39"));
+	renderer.push_key(PAGE_DOWN);
+	CHECK(shows(renderer, "row 40"));
+	CHECK(wait_until([&] () {
+	    return renderer.separator().empty();
+	}));
+    };
+};
+
+int main()
+{
+    auto renderer = std::make_unique<MemoryRenderer>(10, 120);
+    MemoryRenderer& screen = *renderer;
+    auto console = ConsoleInterface::create(std::move(renderer));
+
+    test_messages(screen);
+    test_commands(screen);
+    test_filter(screen);
+    test_scrollback(screen);
+
+    console->shutdown();
+    shutdown();
+    while (!console->is_deletable()) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    };
+    return Tests::failures();
+}
@@ -0,0 +1,151 @@
+#include "../src/mpsc_queue.hpp"
+#include "check.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// MpscQueue on its own: capacity rounding, order, refusing pushes when
+// full, the try_pop eviction the console's drop-oldest policy is built
+// on, and the same under concurrent producers.
+
+namespace {
+    using namespace ConsoleWriter;
+
+    void
+    test_capacity
+    () {
+	CHECK(MpscQueue<int>(0).capacity() == 2);
+	CHECK(MpscQueue<int>(5).capacity() == 8);
+	CHECK(MpscQueue<int>(8).capacity() == 8);
+    };
+
+    void
+    test_full
+    () {
+	MpscQueue<int> queue(4);
+	CHECK(queue.empty());
+	for (int i = 0; i < 4; ++i) {
+	    CHECK(queue.try_push(int(i)));
+	};
+	CHECK(!queue.try_push(4));
+	CHECK(queue.size_approx() == 4);
+	CHECK(!queue.empty());
+
+	int value = -1;
+	CHECK(queue.try_pop(value) && value == 0);
+	CHECK(queue.try_push(4));
+	std::vector<int> popped;
+	CHECK(queue.pop_batch([&] (int&& v) { popped.push_back(v); }, 2) ==
+	      2);
+	CHECK(queue.pop_batch([&] (int&& v) { popped.push_back(v); }) == 2);
+	CHECK((popped == std::vector<int> { 1, 2, 3, 4 }));
+	CHECK(queue.empty());
+	CHECK(!queue.try_pop(value));
+	CHECK(queue.pop_batch([] (int&&) { }) == 0);
+    };
+
+    // the console's drop-oldest overflow: evict the head until the push
+    // fits, so the newest capacity() values survive
+    void
+    test_drop_oldest
+    () {
+	MpscQueue<int> queue(4);
+	size_t dropped = 0;
+	for (int i = 0; i < 10; ++i) {
+	    int oldest;
+	    while (!queue.try_push(int(i))) {
+		if (queue.try_pop(oldest)) {
+		    ++dropped;
+		};
+	    };
+	};
+	CHECK(dropped == 6);
+	std::vector<int> kept;
+	queue.pop_batch([&] (int&& v) { kept.push_back(v); });
+	CHECK((kept == std::vector<int> { 6, 7, 8, 9 }));
+    };
+
+    void
+    test_destroys_values
+    () {
+	auto shared = std::make_shared<int>(0);
+	{
+	    MpscQueue<std::shared_ptr<int>> queue(4);
+	    for (int i = 0; i < 3; ++i) {
+		CHECK(queue.try_push(std::shared_ptr<int>(shared)));
+	    };
+	    std::shared_ptr<int> out;
+	    CHECK(queue.try_pop(out));
+	    out.reset();
+	    CHECK(shared.use_count() == 3);
+	};
+	CHECK(shared.use_count() == 1);
+    };
+
+    // producers evict as the console does while one thread drains; each
+    // producer's values must come out in order and none may be lost
+    void
+    test_concurrent_drop_oldest
+    () {
+	constexpr size_t PRODUCERS { 4 };
+	constexpr uint32_t PER_PRODUCER { 100000 };
+	MpscQueue<uint64_t> queue(64);
+	std::atomic<size_t> dropped { 0 };
+	std::atomic<size_t> running { PRODUCERS };
+	std::vector<int64_t> last(PRODUCERS, -1);
+	size_t out_of_order = 0;
+	size_t received = 0;
+
+	auto take = [&] (uint64_t&& value) {
+	    const size_t producer = static_cast<size_t>(value >> 32);
+	    const int64_t sequence = static_cast<int64_t>(value & 0xffffffff);
+	    if (sequence <= last[producer]) {
+		++out_of_order;
+	    };
+	    last[producer] = sequence;
+	    ++received;
+	};
+
+	std::vector<std::thread> producers;
+	for (size_t p = 0; p < PRODUCERS; ++p) {
+	    producers.emplace_back([&, p] () {
+		for (uint32_t i = 0; i < PER_PRODUCER; ++i) {
+		    const uint64_t value = (uint64_t(p) << 32) | i;
+		    uint64_t oldest;
+		    while (!queue.try_push(uint64_t(value))) {
+			if (queue.try_pop(oldest)) {
+			    dropped.fetch_add(1, std::memory_order_relaxed);
+			};
+		    };
+		};
+		running.fetch_sub(1, std::memory_order_release);
+	    });
+	};
+	while (running.load(std::memory_order_acquire) > 0) {
+	    if (queue.pop_batch(take) == 0) {
+		std::this_thread::yield();
+	    };
+	};
+	for (auto& producer : producers) {
+	    producer.join();
+	};
+	queue.pop_batch(take);
+
+	CHECK(out_of_order == 0);
+	CHECK(received + dropped.load() == PRODUCERS * PER_PRODUCER);
+	CHECK(queue.empty());
+    };
+};
+
+int main()
+{
+    test_capacity();
+    test_full();
+    test_drop_oldest();
+    test_destroys_values();
+    test_concurrent_drop_oldest();
+    return Tests::failures();
+}
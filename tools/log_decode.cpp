@@ -0,0 +1,117 @@
+#include "../src/log_sink.hpp"
+#include "../src/timestamp.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Prints a binary console log (LogFormat::BINARY) as the text the console
+// showed, one line per record.
+//
+//     log_decode [--micros] FILE...
+
+namespace {
+    uint64_t
+    get
+    (unsigned char const* in, size_t const bytes) noexcept {
+	uint64_t value = 0;
+	for (size_t i = bytes; i > 0; --i) {
+	    value = (value << 8) | in[i - 1];
+	};
+	return value;
+    };
+
+    bool
+    decode
+    (char const* path) {
+	using namespace ConsoleWriter;
+	std::FILE* file = std::fopen(path, "rb");
+	if (!file) {
+	    std::fprintf(stderr, "log_decode: cannot open %s\n", path);
+	    return false;
+	};
+	unsigned char header[8];
+	if (std::fread(header, 1, sizeof(header), file) != sizeof(header) ||
+	    std::memcmp(header, LogFile::MAGIC, 4) != 0 ||
+	    get(header + 4, 4) != LogFile::VERSION) {
+	    std::fprintf(stderr, "log_decode: %s is not a binary log\n", path);
+	    std::fclose(file);
+	    return false;
+	};
+
+	std::vector<unsigned char> record;
+	std::string line;
+	bool ok = true;
+	unsigned char size_bytes[4];
+	while (std::fread(size_bytes, 1, 4, file) == 4) {
+	    const size_t size = get(size_bytes, 4);
+	    record.resize(size);
+	    if (size < 10 || std::fread(record.data(), 1, size, file) != size) {
+		std::fprintf(stderr, "log_decode: %s: truncated record\n",
+			     path);
+		ok = false;
+		break;
+	    };
+	    const std::chrono::system_clock::time_point wall
+		(std::chrono::duration_cast<std::chrono::system_clock::duration>
+		 (std::chrono::nanoseconds
+		  (static_cast<int64_t>(get(record.data(), 8)))));
+	    const bool timestamped = record[8] & LogFile::TIMESTAMPED;
+	    const size_t chunks = record[9];
+	    size_t text = 10 + 5 * chunks;
+	    if (text > size) {
+		std::fprintf(stderr, "log_decode: %s: bad record\n", path);
+		ok = false;
+		break;
+	    };
+
+	    line.clear();
+	    if (timestamped) {
+		char stamp[Timestamp::MAX_WIDTH];
+		line.append(stamp, Timestamp::format_wall(wall, true, stamp));
+	    };
+	    for (size_t i = 0; i < chunks; ++i) {
+		const size_t length = get(record.data() + 10 + 5 * i + 1, 4);
+		if (text + length > size) {
+		    std::fprintf(stderr, "log_decode: %s: bad chunk\n", path);
+		    ok = false;
+		    break;
+		};
+		if (!line.empty()) {
+		    line.push_back(' ');
+		};
+		line.append(reinterpret_cast<char const*>(record.data()) + text,
+			    length);
+		text += length;
+	    };
+	    if (!ok) {
+		break;
+	    };
+	    std::printf("%s\n", line.c_str());
+	};
+	std::fclose(file);
+	return ok;
+    };
+};
+
+int main(int argc, char *argv[])
+{
+    using namespace ConsoleWriter;
+    int first = 1;
+    if (argc > 1 && std::strcmp(argv[1], "--micros") == 0) {
+	Timestamp::set_precision(Timestamp::Precision::MICROSECONDS);
+	++first;
+    };
+    if (first >= argc) {
+	std::fprintf(stderr, "usage: log_decode [--micros] FILE...\n");
+	return 2;
+    };
+    bool ok = true;
+    for (int i = first; i < argc; ++i) {
+	ok = decode(argv[i]) && ok;
+    };
+    return ok ? 0 : 1;
+}